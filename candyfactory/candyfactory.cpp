@@ -25,7 +25,7 @@ candyfactory::candyfactory(void)
 _ncase_unopened(NUM_CASES), _curr_avg_unopened(0), _game_num(0)
 {
     cout << endl << "~~~WELCOME TO GAME OF DEAL OR NO DEAL~~~" << endl << endl;
-    srand(unsigned(time(NULL)));
+    rng_seed(&_rng, uint64_t(time(NULL)));
     // zero out game stats
     _game_stats.avg_amount_won = 0;
     _game_stats.avg_final_round = 0;
@@ -245,13 +245,11 @@ void candyfactory::_shuffle_cases(void)
 {
     unsigned i, j;
     float    temp;
-    unsigned rand_num;
-    rand_num = rand();
     // iterate last case number from 26 to 1
     // pick a case num randomly between 1 and the +last, and swap it with the last case
     for (i = NUM_CASES; i>0; --i) {
         
-        j = rand_num%i;
+        j = rng_bounded(&_rng, i);
         temp = _arr_cases[i-1].money;
         _arr_cases[i-1].money = _arr_cases[j].money;
         _arr_cases[j].money = temp;
@@ -278,8 +276,7 @@ void candyfactory::_user_input_select_case(void)
         }
     }
     else {
-        select = rand();
-        select = select%NUM_CASES + 1;
+        select = rng_bounded(&_rng, NUM_CASES) + 1;
     }
     
     _player_case = select;
@@ -307,8 +304,7 @@ void candyfactory::_open_cases(void)
             cin >> select;
         }
         else {
-            select = rand();
-            select = select%NUM_CASES + 1;
+            select = rng_bounded(&_rng, NUM_CASES) + 1;
             while (_arr_cases[select - 1].case_status == 0 || select == _player_case) {
                 select = select%NUM_CASES + 1;
             }
@@ -354,7 +350,7 @@ float candyfactory::_banker_offer(void)
 {
     float left_bracket = bracket[_curr_rnd_num - 1][0];
     float right_bracket = bracket[_curr_rnd_num - 1][1];
-    float alpha = float(rand()) / (RAND_MAX+1);
+    float alpha = float(rng_double(&_rng));
     float fraction = left_bracket + (right_bracket - left_bracket)*alpha;
     float offer = fraction*_curr_avg_unopened;
 
@@ -18,6 +18,7 @@ All includes here
 #define __CANDYFACTORY_H__
 
 #include "../util/util.h"
+#include "../util/rng.h"
 
 #define HIGHEST_PRIZE (1000000)
 #define LOWEST_PRIZE  (0.01)
@@ -109,6 +110,7 @@ class candyfactory {
         unsigned _ncase_unopened; // number of unopened cases yet
         float    _curr_avg_unopened; // avg value of unopened cases
         unsigned _game_num; // number of the iteraton of game play
+        rng_t    _rng; // shuffles, computer's case picks and banker offers
         // METHODS
         bool     _user_input_to_start(void); // to play interactively or not, oneshot or not
         float    _play_a_game(void); // play a game of deal no deal
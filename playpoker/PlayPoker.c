@@ -24,6 +24,7 @@
 #include <time.h>
 #include <stdbool.h>
 
+#include "../util/rng.h"
 
 #define DECK_SIZE        (52)
 #define NUM_DECK         (1)
@@ -172,7 +173,7 @@ static int       deck_cut_val = 0;
 static player_t  players[MAX_PLAYERS];
 static int       num_players;
 static int       dealer_idx;
-static int       rand_num;
+static rng_t     rng;
 
 // Function prototypes
 static void fillDeck( void );
@@ -218,7 +219,7 @@ int main( void )
     dealer_idx = 0;
     
     seed = (int)time(NULL);
-    srand(seed);
+    rng_seed(&rng, (uint64_t)seed);
     DBG printf("seed=%d\n",seed);
 
     // clear screen
@@ -470,11 +471,9 @@ static void shuffleDeck( void )
     int    i, j;
     card_t temp;
     
-    rand_num = rand();
-    
     // for shuffling, treat all decks together as one big deck
     for( i=DECK_SIZE*NUM_DECK-1; i>0; i--) {
-        j = rand()%i;
+        j = (int)rng_bounded(&rng, (uint32_t)(i+1));
         temp = ((card_t *)deck)[i];
         ((card_t *)deck)[i] = ((card_t *)deck)[j];
         ((card_t *)deck)[j] = temp;
@@ -507,7 +506,7 @@ static void cutDeck( void )
     scanf("%d",&deck_cut_val);
     scanf("%c",&dummy_char);
 #else
-    deck_cut_val = rand_num % (DECK_SIZE*NUM_DECK);
+    deck_cut_val = (int)rng_bounded(&rng, DECK_SIZE*NUM_DECK);
 #endif /* USER_INPUT */
 
     DBG printf("%d\n",deck_cut_val);
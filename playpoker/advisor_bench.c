@@ -0,0 +1,292 @@
+/********************************************************************
+  Author: Vikas Yadav
+  Filename: advisor_bench.c
+  Copyright (c) 2017-2026 Vikas Yadav. All rights reserved.
+
+  Micro-benchmarks for the advisor's hot paths, with fixed seeds and a
+  fixed set of spots so two builds can be compared run for run:
+    eval7         one 7-card value, over a fixed set of random hands
+    best_hand     the same hands as a rank_t
+    deck_draw     one card of the partial Fisher-Yates shuffle, dealing
+                  a 9-opponent showdown at a time
+    omaha_best_hand
+                  one Omaha hand the plain way, 60 five-card evaluations,
+                  over a fixed set of random 4-card holdings and boards
+    omaha_finish  the same hands on a prepared board, one board
+                  preparation per 4 hands as in a 3-opponent trial
+    simulate      Monte Carlo equity for AhKh preflop, on the flop, turn
+                  and river, against 1 to 9 opponents, and the same for
+                  AhKhQdJd in Omaha
+
+  Each benchmark runs --reps times; every repetition does the same work
+  from the same seed. Results are one JSON object on stdout, giving the
+  mean, standard deviation, min and max ns per operation over the
+  repetitions (and trials per second for simulate), so runs can be
+  stored and diffed across commits.
+
+  Build:  gcc -O2 -pthread -o advisor_bench advisor_bench.c -lm
+  Usage:  ./advisor_bench [--reps N] [--trials N] [--threads N] [--seed S]
+                         [--sampling plain|stratified]
+          (default: 5 reps, 100,000 trials per spot, 1 thread, seed 1,
+          plain sampling)
+********************************************************************/
+#include "libpokeradvisor.c"
+
+#define BENCH_REPS      5
+#define BENCH_TRIALS    100000
+#define BENCH_SEED      1
+#define BENCH_HANDS     (1 << 16)   /* fixed random 7-card hands */
+#define BENCH_EVALS     (1 << 22)   /* evaluations per repetition */
+#define BENCH_DEALS     (1 << 18)   /* showdown deals per repetition */
+#define BENCH_OMAHA     (1 << 12)   /* fixed random Omaha boards, 4 holdings each */
+#define BENCH_OMAHA_EVALS  (1 << 18)   /* Omaha hands per repetition */
+#define MAX_REPS        100
+
+static const char *BENCH_HOLE  = "Ah Kh";
+static const char *BENCH_OMAHA_HOLE = "Ah Kh Qd Jd";
+static const char *BENCH_BOARD = "Qh Jh 2c 7d 3s";
+static const char *STREET_NAMES[] = {"preflop", "flop", "turn", "river"};
+static const int   STREET_CARDS[] = {0, 3, 4, 5};
+
+typedef struct {
+    int    reps;
+    double ns[MAX_REPS];   /* per operation, by repetition */
+} bench_stats_t;
+
+static cardmask_t hands[BENCH_HANDS];
+static cardmask_t omaha_boards[BENCH_OMAHA], omaha_holes[BENCH_OMAHA][4];
+static volatile uint64_t sink;   /* keeps results live */
+
+static void bench_record(bench_stats_t *st, const struct timespec *start, long ops)
+{
+    st->ns[st->reps++] = elapsed_ms(start) * 1e6 / ops;
+}
+
+/* "ns_per_op":{...} for one benchmark's repetitions */
+static void bench_print(const bench_stats_t *st)
+{
+    double sum = 0.0, sq = 0.0, lo = st->ns[0], hi = st->ns[0];
+    for (int i = 0; i < st->reps; i++) {
+        sum += st->ns[i];
+        if (st->ns[i] < lo) lo = st->ns[i];
+        if (st->ns[i] > hi) hi = st->ns[i];
+    }
+    double mean = sum / st->reps;
+    for (int i = 0; i < st->reps; i++) sq += (st->ns[i] - mean) * (st->ns[i] - mean);
+    double sd = st->reps > 1 ? sqrt(sq / (st->reps - 1)) : 0.0;
+    printf("\"ns_per_op\":{\"mean\":%.3f,\"sd\":%.3f,\"min\":%.3f,\"max\":%.3f}", mean, sd, lo, hi);
+}
+
+static void bench_eval7(bench_stats_t *st)
+{
+    struct timespec start;
+    uint64_t acc = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCH_EVALS; i++)
+        acc += eval7(hands[i & (BENCH_HANDS - 1)]);
+    bench_record(st, &start, BENCH_EVALS);
+    sink += acc;
+}
+
+static void bench_best_hand(bench_stats_t *st)
+{
+    struct timespec start;
+    uint64_t acc = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCH_EVALS; i++) {
+        rank_t r = best_hand(hands[i & (BENCH_HANDS - 1)]);
+        acc += (uint64_t)(r.rankVal + r.high + r.kicker);
+    }
+    bench_record(st, &start, BENCH_EVALS);
+    sink += acc;
+}
+
+/* Deal two hole cards to 9 opponents and a board from the 50 live cards */
+static void bench_deck_draw(bench_stats_t *st, uint64_t seed)
+{
+    const int n = DECK_SIZE - 2, per_deal = 2 * MAX_OPPONENTS + 5;
+    uint8_t deck[DECK_SIZE], pos[DECK_SIZE];
+    struct timespec start;
+    cardmask_t acc = 0;
+    rng_t rng;
+
+    rng_seed(&rng, seed);
+    for (int i = 0; i < n; i++) deck[i] = pos[i] = (uint8_t)i;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long d = 0; d < BENCH_DEALS; d++)
+        for (int i = 0; i < per_deal; i++)
+            acc ^= deck_draw(deck, pos, n, i, &rng);
+    bench_record(st, &start, (long)BENCH_DEALS * per_deal);
+    sink += acc;
+}
+
+static void bench_omaha_best_hand(bench_stats_t *st)
+{
+    struct timespec start;
+    uint64_t acc = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCH_OMAHA_EVALS; i++) {
+        long d = (i / 4) & (BENCH_OMAHA - 1);
+        rank_t r = omaha_best_hand(omaha_holes[d][i & 3], omaha_boards[d]);
+        acc += (uint64_t)(r.rankVal + r.high + r.kicker);
+    }
+    bench_record(st, &start, BENCH_OMAHA_EVALS);
+    sink += acc;
+}
+
+static void bench_omaha_finish(bench_stats_t *st)
+{
+    struct timespec start;
+    omaha_board_t ob;
+    uint64_t acc = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCH_OMAHA_EVALS; i += 4) {
+        long d = (i / 4) & (BENCH_OMAHA - 1);
+        omaha_prepare(&ob, omaha_boards[d]);
+        for (int h = 0; h < 4; h++) acc += omaha_finish(&ob, omaha_holes[d][h]);
+    }
+    bench_record(st, &start, BENCH_OMAHA_EVALS);
+    sink += acc;
+}
+
+/* One simulate() call; returns its equity so repetitions can be compared */
+static double bench_simulate(bench_stats_t *st, cardmask_t hole, cardmask_t board,
+                             int opponents, const sim_opts_t *base, double *reduction)
+{
+    sim_opts_t opts = *base;
+    struct timespec start;
+    sim_result_t res;
+    rank_t best;
+
+    opts.opponents = opponents;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double eq = simulate(hole, board, &best, &opts, &res);
+    bench_record(st, &start, res.outcomes);
+    *reduction = res.variance_reduction;
+    return eq;
+}
+
+/* Cards from a space-separated list of fixed, valid card names */
+static int parse_cards(const char *s, card_t *cards)
+{
+    char buf[32];
+    int n = 0;
+
+    snprintf(buf, sizeof(buf), "%s", s);
+    for (char *tok = strtok(buf, " "); tok; tok = strtok(NULL, " "))
+        if (parse_card(tok, &cards[n])) n++;
+    return n;
+}
+
+int main(int argc, char *argv[])
+{
+    int reps = BENCH_REPS;
+    sim_opts_t opts = sim_opts_default();
+    bench_stats_t st;
+
+    opts.trials = BENCH_TRIALS;
+    opts.seed = BENCH_SEED;
+    opts.exact_budget = 0;   /* always sample, so every spot times the same path */
+    opts.target_se = 0.0;    /* and always runs its full trial count */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i+1 < argc) reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trials") == 0 && i+1 < argc) opts.trials = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) opts.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) opts.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--sampling") == 0 && i+1 < argc) opts.stratified = strcmp(argv[++i], "stratified") == 0;
+        else {
+            fprintf(stderr, "Usage: %s [--reps N] [--trials N] [--threads N] [--seed S]"
+                " [--sampling plain|stratified]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (reps < 1 || reps > MAX_REPS || opts.trials < 1 || opts.threads < 1 || opts.threads > MAX_THREADS) {
+        fprintf(stderr, "reps must be 1..%d, trials positive and threads 1..%d.\n", MAX_REPS, MAX_THREADS);
+        return 1;
+    }
+
+    eval_init();
+    rng_t rng;
+    rng_seed(&rng, opts.seed);
+    for (int i = 0; i < BENCH_HANDS; i++) {
+        cardmask_t m = 0;
+        while (mask_count(m) < 7) m |= 1ULL << rng_bounded(&rng, DECK_SIZE);
+        hands[i] = m;
+    }
+    for (int d = 0; d < BENCH_OMAHA; d++) {
+        cardmask_t used = 0;
+        while (mask_count(used) < 5) used |= 1ULL << rng_bounded(&rng, DECK_SIZE);
+        omaha_boards[d] = used;
+        for (int h = 0; h < 4; h++) {
+            cardmask_t m = 0;
+            while (mask_count(m) < 4) {
+                cardmask_t c = 1ULL << rng_bounded(&rng, DECK_SIZE);
+                if (!(c & used)) { m |= c; used |= c; }
+            }
+            omaha_holes[d][h] = m;
+        }
+    }
+
+    printf("{\"benchmark\":\"advisor_bench\",\"reps\":%d,\"seed\":%llu,\"threads\":%d,"
+           "\"trials\":%d,\"sampling\":\"%s\",\"results\":[\n", reps, (unsigned long long)opts.seed,
+           opts.threads, opts.trials, opts.stratified ? "stratified" : "plain");
+
+    memset(&st, 0, sizeof(st));
+    for (int r = 0; r < reps; r++) bench_eval7(&st);
+    printf("{\"name\":\"eval7\",\"ops\":%d,", BENCH_EVALS);
+    bench_print(&st);
+    printf("},\n");
+
+    memset(&st, 0, sizeof(st));
+    for (int r = 0; r < reps; r++) bench_best_hand(&st);
+    printf("{\"name\":\"best_hand\",\"ops\":%d,", BENCH_EVALS);
+    bench_print(&st);
+    printf("},\n");
+
+    memset(&st, 0, sizeof(st));
+    for (int r = 0; r < reps; r++) bench_deck_draw(&st, opts.seed);
+    printf("{\"name\":\"deck_draw\",\"ops\":%ld,", (long)BENCH_DEALS * (2 * MAX_OPPONENTS + 5));
+    bench_print(&st);
+    printf("},\n");
+
+    memset(&st, 0, sizeof(st));
+    for (int r = 0; r < reps; r++) bench_omaha_best_hand(&st);
+    printf("{\"name\":\"omaha_best_hand\",\"ops\":%d,", BENCH_OMAHA_EVALS);
+    bench_print(&st);
+    printf("},\n");
+
+    memset(&st, 0, sizeof(st));
+    for (int r = 0; r < reps; r++) bench_omaha_finish(&st);
+    printf("{\"name\":\"omaha_finish\",\"ops\":%d,", BENCH_OMAHA_EVALS);
+    bench_print(&st);
+    printf("}");
+
+    card_t hole[4], board[5];
+    parse_cards(BENCH_BOARD, board);
+    for (int omaha = 0; omaha <= 1; omaha++) {
+        int num_hole = parse_cards(omaha ? BENCH_OMAHA_HOLE : BENCH_HOLE, hole);
+        opts.omaha = omaha;
+        for (int s = 0; s < 4; s++)
+            for (int opp = 1; opp <= MAX_OPPONENTS; opp++) {
+                double eq = 0.0, reduction = 1.0;
+                bool stable = true;
+                memset(&st, 0, sizeof(st));
+                for (int r = 0; r < reps; r++) {
+                    double e = bench_simulate(&st, cards_mask(hole, num_hole), cards_mask(board, STREET_CARDS[s]),
+                                              opp, &opts, &reduction);
+                    stable &= r == 0 || e == eq;
+                    eq = e;
+                }
+                double best = st.ns[0];
+                for (int r = 1; r < st.reps; r++) if (st.ns[r] < best) best = st.ns[r];
+                printf(",\n{\"name\":\"simulate\",\"game\":\"%s\",\"street\":\"%s\",\"opponents\":%d,"
+                       "\"ops\":%d,\"equity\":%.6f,\"deterministic\":%s,\"variance_reduction\":%.2f,"
+                       "\"trials_per_s\":%.0f,", omaha ? "omaha" : "holdem", STREET_NAMES[s], opp, opts.trials,
+                       eq, stable ? "true" : "false", reduction, 1e9 / best);
+                bench_print(&st);
+                printf("}");
+            }
+    }
+    printf("\n]}\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+/********************************************************************
+  Author: Vikas Yadav
+  Filename: eval_census.c
+  Copyright (c) 2017-2026 Vikas Yadav. All rights reserved.
+
+  Seven-card census: ranks all 133,784,560 seven-card hands with each
+  of the advisor's evaluators, across every core, and checks the hand
+  categories against their known exact counts. It serves as the release
+  gate for the evaluator and as its throughput number.
+
+  Evaluators timed:
+    best_hand()     what the advisor reports a hand as (rank_t)
+    eval7()         the 7-card value used by Monte Carlo trials
+    board_finish()  one board_prepare() per 5-card board, then two hole
+                    cards at a time, as exact enumeration does
+
+  Every evaluator must also reach the same sum of hand values, which
+  catches a wrong kicker that the category counts alone would miss.
+
+  Build:  gcc -O2 -pthread -o eval_census eval_census.c -lm
+  Usage:  ./eval_census [--threads N]   (default: all cores)
+  Exits 1 if any count or sum is off.
+********************************************************************/
+#include "libpokeradvisor.c"
+
+#define CENSUS_HANDS  133784560L
+
+/* Seven-card hands by rankVal: royal flush first, high card last */
+static const long CENSUS_EXPECTED[NUM_RANKS] = {
+    4324, 37260, 224848, 3473184, 4047644,
+    6180020, 6461620, 31433400, 58627800, 23294460
+};
+
+typedef enum { CENSUS_BEST_HAND, CENSUS_EVAL7, CENSUS_BOARD, NUM_EVALUATORS } census_eval_t;
+
+static const char *EVALUATOR_NAMES[NUM_EVALUATORS] = {"best_hand()", "eval7()", "board_finish()"};
+
+/*
+ * The hands are split by their top two cards (f, g): a unit holds every
+ * hand whose other five cards lie below f, C(f, 5) of them. Units are
+ * claimed largest first so the threads finish together.
+ */
+#define NUM_UNITS  (DECK_SIZE * (DECK_SIZE - 1) / 2)
+
+typedef struct {
+    census_eval_t evaluator;
+    int           num_units;
+    uint8_t       unit_f[NUM_UNITS], unit_g[NUM_UNITS];
+    int           next;               /* next unit to claim */
+    long          counts[NUM_RANKS];  /* by rankVal */
+    uint64_t      value_sum;          /* of every hand value */
+} census_job_t;
+
+/* Tally one unit: boards c<d<e<f<g, holes a<b<c */
+static void census_unit(census_job_t *job, int f, int g, long counts[NUM_RANKS], uint64_t *sum)
+{
+    cardmask_t top = (1ULL << f) | (1ULL << g);
+
+    for (int e = 2; e < f; e++)
+        for (int d = 1; d < e; d++)
+            for (int c = 0; c < d; c++) {
+                cardmask_t board = top | (1ULL << e) | (1ULL << d) | (1ULL << c);
+                board_eval_t be;
+                if (job->evaluator == CENSUS_BOARD) board_prepare(&be, board);
+                for (int b = 0; b < c; b++)
+                    for (int a = 0; a < b; a++) {
+                        cardmask_t hole = (1ULL << a) | (1ULL << b);
+                        hand_val_t v;
+                        if (job->evaluator == CENSUS_BEST_HAND) {
+                            rank_t r = best_hand(board | hole);
+                            v = rank_to_val(r);
+                        } else if (job->evaluator == CENSUS_EVAL7) {
+                            v = eval7(board | hole);
+                        } else {
+                            v = board_finish(&be, hole);
+                        }
+                        counts[9 - VAL_CATEGORY(v)]++;
+                        *sum += v;
+                    }
+            }
+}
+
+static void *census_worker(void *arg)
+{
+    census_job_t *job = arg;
+    long counts[NUM_RANKS] = {0};
+    uint64_t sum = 0;
+    int u;
+
+    while ((u = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->num_units)
+        census_unit(job, job->unit_f[u], job->unit_g[u], counts, &sum);
+    for (int r = 0; r < NUM_RANKS; r++)
+        __atomic_fetch_add(&job->counts[r], counts[r], __ATOMIC_RELAXED);
+    __atomic_fetch_add(&job->value_sum, sum, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void run_pool(void *(*fn)(void *), census_job_t *job, int threads)
+{
+    pthread_t tids[MAX_THREADS];
+    int started = 1;
+
+    job->next = 0;
+    for (int t = 1; t < threads; t++, started++)
+        if (pthread_create(&tids[t], NULL, fn, job) != 0)
+            break;
+    fn(job);
+    for (int t = 1; t < started; t++)
+        pthread_join(tids[t], NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    static census_job_t job;
+    long counts[NUM_EVALUATORS][NUM_RANKS];
+    uint64_t sums[NUM_EVALUATORS];
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) threads = atoi(argv[++i]);
+        else {
+            printf("Usage: %s [--threads N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    eval_init();
+    for (int f = DECK_SIZE - 2; f >= 4; f--)
+        for (int g = f + 1; g < DECK_SIZE; g++) {
+            job.unit_f[job.num_units] = (uint8_t)f;
+            job.unit_g[job.num_units++] = (uint8_t)g;
+        }
+
+    printf("Census of %ld seven-card hands on %d thread%s\n\n", CENSUS_HANDS, threads,
+        threads == 1 ? "" : "s");
+    printf("%-16s %10s %12s  %s\n", "evaluator", "ms", "Mhands/s", "counts");
+    for (int e = 0; e < NUM_EVALUATORS; e++) {
+        struct timespec start;
+        job.evaluator = (census_eval_t)e;
+        memset(job.counts, 0, sizeof(job.counts));
+        job.value_sum = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        run_pool(census_worker, &job, threads);
+        double ms = elapsed_ms(&start);
+
+        bool ok = true;
+        for (int r = 0; r < NUM_RANKS; r++) ok &= job.counts[r] == CENSUS_EXPECTED[r];
+        memcpy(counts[e], job.counts, sizeof(job.counts));
+        sums[e] = job.value_sum;
+        printf("%-16s %10.0f %12.1f  %s\n", EVALUATOR_NAMES[e], ms, CENSUS_HANDS / ms / 1000.0,
+            ok ? "PASS" : "FAIL");
+        failed += !ok;
+        if (e > 0 && sums[e] != sums[0]) {
+            printf("  value sum %llu differs from best_hand()'s %llu\n",
+                (unsigned long long)sums[e], (unsigned long long)sums[0]);
+            failed++;
+        }
+    }
+
+    printf("\n%-16s %10s", "category", "expected");
+    for (int e = 0; e < NUM_EVALUATORS; e++) printf(" %14s", EVALUATOR_NAMES[e]);
+    printf("\n");
+    for (int r = 0; r < NUM_RANKS; r++) {
+        printf("%-16s %10ld", RANK_NAMES[r], CENSUS_EXPECTED[r]);
+        for (int e = 0; e < NUM_EVALUATORS; e++)
+            printf(" %14ld%s", counts[e][r], counts[e][r] == CENSUS_EXPECTED[r] ? "" : "*");
+        printf("\n");
+    }
+    printf("\n%s\n", failed ? "CENSUS FAILED" : "CENSUS PASSED");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,690 @@
+/********************************************************************
+  Author: Vikas Yadav
+  Filename: hand_analyzer.c
+  Copyright (c) 2017-2026 Vikas Yadav. All rights reserved.
+
+  Hand-history analyzer: streams a text log of played hands and reports,
+  for every hand, each player's equity on every street against the other
+  players still in, and how many chips each decision gave up against the
+  advisor's best action. A summary of the expected-value loss per player
+  closes the output.
+
+  The work runs as a pipeline over a fixed ring of hand slots, so memory
+  stays the same however long the log is:
+    reader   (this thread) parses the log into free slots, one hand each
+    workers  compute the equities and rate the decisions (--threads N)
+    writer   prints finished hands in log order and keeps the summary
+  The reader waits for the writer to free a slot when the ring is full.
+
+  Equity on a street is among the players whose cards are known and who
+  have not folded: exact over every runout on the flop and turn, from
+  --runouts N sampled boards preflop. A decision is rated like a
+  poker_advisor query (equity against random hands for the opponents
+  still in, then the expected value of each action), so its loss is the
+  best action's value less the value of what was done. Spots repeat a
+  lot across hands, and the advisor's equity cache answers repeats.
+
+  Log format (this tool's own; no game writes it, though the action
+  wording follows the web game's status text; one hand per block):
+    Hand #17
+    Seat: You $1000 [Ah Kh]
+    Seat: Alice $1000 [7c 7d]
+    Seat: Bob $980                  (cards not shown)
+    Alice posts $10
+    Bob posts $20
+    You raises to $60
+    Alice calls $50
+    Bob folds.
+    Flop: [Qh Jh 2c]
+    Alice checks.
+    You raises to $80
+    Alice goes all-in ($940)
+    Turn: [8d]
+    River: [3s]
+  Actions are posts, folds, checks, calls $X, bets $X, raises to $Y and
+  goes all-in ($Z) (Z: the player's total bet on the street). Other
+  lines, such as winners and showdowns, are skipped.
+
+  Build:  gcc -O2 -pthread -o hand_analyzer hand_analyzer.c -lm
+  Usage:  ./hand_analyzer [--threads N] [--runouts N] [--seed S] [log]
+          (default: all cores, 5000 preflop runouts, seed 1, stdin)
+
+  Output: one JSON line per hand, then {"summary":...}.
+********************************************************************/
+#include "libpokeradvisor.c"
+
+#define HH_MAX_SEATS     (MAX_OPPONENTS + 1)
+#define HH_MAX_ACTIONS   128
+#define HH_NAME_MAX      24
+#define HH_LINE_MAX      256
+#define HH_RUNOUTS       5000     /* preflop boards sampled per hand */
+#define HH_CACHE         4096     /* advisor equity cache entries, ~536 bytes each */
+#define HH_MAX_PLAYERS   256      /* names summarized; the rest as "(others)" */
+#define HH_MISTAKE       BIG_BLIND   /* a decision losing this much counts as a mistake */
+
+enum { STREET_PREFLOP, STREET_FLOP, STREET_TURN, STREET_RIVER, NUM_STREETS };
+static const char *STREET_NAMES[NUM_STREETS] = {"preflop", "flop", "turn", "river"};
+static const int   STREET_BOARD[NUM_STREETS] = {0, 3, 4, 5};
+
+typedef enum { ACT_FOLD, ACT_CHECK, ACT_CALL, ACT_RAISE } act_t;
+static const char *ACT_NAMES[] = {"fold", "check", "call", "raise"};
+
+/* One voluntary action, as the player faced it */
+typedef struct {
+    int         seat, street;
+    act_t       act;
+    int         pot, to_call;   /* before acting */
+    int         raise;          /* chips over the call */
+    int         opponents;      /* others still in */
+    bool        rated;          /* the player's cards are known */
+    double      ev, best_ev;
+    const char *best;           /* the advisor's action and amount */
+    int         best_amount;
+} decision_t;
+
+typedef struct {
+    char   name[HH_NAME_MAX];
+    bool   known;
+    card_t hole[2];
+    double equity[NUM_STREETS];   /* NAN where not computed */
+    double ev_loss;
+    int    decisions;             /* rated */
+} seat_t;
+
+typedef struct {
+    long       seq;               /* hands before this one in the log */
+    char       id[32];
+    char       err[96];           /* why the hand was not analyzed, "" if it was */
+    int        num_seats;
+    seat_t     seat[HH_MAX_SEATS];
+    card_t     board[5];
+    int        num_board;
+    int        streets;           /* streets dealt, 1..NUM_STREETS */
+    unsigned   live[NUM_STREETS]; /* seats not folded as each street starts */
+    int        num_decisions;
+    decision_t decision[HH_MAX_ACTIONS];
+} hand_t;
+
+/* The reader's betting state for the hand being parsed */
+typedef struct {
+    hand_t  *h;
+    int      bet[HH_MAX_SEATS];   /* on this street */
+    int      current;             /* highest bet on this street */
+    int      pot;
+    unsigned in;                  /* seats not folded */
+} parse_state_t;
+
+typedef struct {
+    char   name[HH_NAME_MAX];
+    long   hands, decisions, mistakes;
+    double ev_loss;
+} player_stats_t;
+
+enum { SLOT_FREE, SLOT_PARSED, SLOT_DONE };
+
+typedef struct {
+    hand_t             *slot;
+    int                *state;
+    int                 num_slots;
+    long                parsed, claimed, written;   /* hands through each stage */
+    bool                eof;
+    pthread_mutex_t     lock;
+    pthread_cond_t      changed;
+    const pa_context_t *ctx;
+    uint64_t            seed;
+    int                 runouts;
+    FILE               *out;
+    /* the writer's summary */
+    player_stats_t      players[HH_MAX_PLAYERS + 1];   /* the last: everyone else */
+    int                 num_players;
+    long                hands, errors, decisions, mistakes;
+    double              ev_loss;
+} pipeline_t;
+
+/*
+ * Parsing
+ */
+
+/* "$1,000", "($940)", "[Ah", "Kh]": the number or card inside */
+static char *strip(char *tok)
+{
+    while (*tok == '$' || *tok == '(' || *tok == '[') tok++;
+    size_t n = strlen(tok);
+    while (n && strchr(")].,", tok[n-1])) tok[--n] = '\0';
+    return tok;
+}
+
+static int chips(char *tok)
+{
+    char *s = strip(tok), digits[24];
+    int n = 0;
+    for (; *s && n < (int)sizeof(digits) - 1; s++)
+        if (*s != ',') digits[n++] = *s;
+    digits[n] = '\0';
+    return atoi(digits);
+}
+
+static int find_seat(const hand_t *h, const char *name)
+{
+    for (int s = 0; s < h->num_seats; s++)
+        if (strcmp(h->seat[s].name, name) == 0) return s;
+    return -1;
+}
+
+static void add_decision(parse_state_t *ps, int seat, act_t act, int raise)
+{
+    hand_t *h = ps->h;
+    int others = __builtin_popcount(ps->in) - 1;
+    if (others < 1 || h->num_decisions == HH_MAX_ACTIONS) return;
+    decision_t *d = &h->decision[h->num_decisions++];
+    memset(d, 0, sizeof(*d));
+    d->seat = seat;
+    d->street = h->streets - 1;
+    d->act = act;
+    d->pot = ps->pot;
+    d->to_call = ps->current > ps->bet[seat] ? ps->current - ps->bet[seat] : 0;
+    d->raise = raise;
+    d->opponents = others < MAX_OPPONENTS ? others : MAX_OPPONENTS;
+}
+
+/* Put chips in to reach a street bet of total */
+static void bet_to(parse_state_t *ps, int seat, int total)
+{
+    if (total < ps->bet[seat]) return;
+    ps->pot += total - ps->bet[seat];
+    ps->bet[seat] = total;
+    if (total > ps->current) ps->current = total;
+}
+
+/* One line of the current hand; false (with h->err set) on a bad one */
+static bool parse_line(parse_state_t *ps, char *line)
+{
+    hand_t *h = ps->h;
+    char *tok[16], *save = NULL;
+    int ntok = 0;
+
+    for (char *t = strtok_r(line, " \t\r\n", &save); t && ntok < 16; t = strtok_r(NULL, " \t\r\n", &save))
+        tok[ntok++] = t;
+    if (ntok == 0) return true;
+
+    if (strcmp(tok[0], "Seat:") == 0) {
+        if (h->streets > 1 || h->num_decisions || ps->pot) {
+            snprintf(h->err, sizeof(h->err), "seat listed after the action started");
+            return false;
+        }
+        if (ntok < 2 || h->num_seats == HH_MAX_SEATS || find_seat(h, tok[1]) >= 0) {
+            snprintf(h->err, sizeof(h->err), "bad, repeated or too many seats");
+            return false;
+        }
+        seat_t *s = &h->seat[h->num_seats];
+        snprintf(s->name, sizeof(s->name), "%s", tok[1]);
+        s->known = ntok > 3;   /* cards shown, and then they must parse */
+        if (s->known && (ntok < 5 || !parse_card(strip(tok[3]), &s->hole[0]) ||
+                         !parse_card(strip(tok[4]), &s->hole[1]))) {
+            snprintf(h->err, sizeof(h->err), "bad hole cards for %s", s->name);
+            return false;
+        }
+        ps->in |= 1u << h->num_seats++;
+        return true;
+    }
+
+    static const char *street_tags[NUM_STREETS] = {"", "Flop:", "Turn:", "River:"};
+    for (int st = STREET_FLOP; st < NUM_STREETS; st++) {
+        if (strcmp(tok[0], street_tags[st]) != 0) continue;
+        int want = STREET_BOARD[st] - STREET_BOARD[st-1];
+        if (h->streets != st || ntok - 1 != want) {
+            snprintf(h->err, sizeof(h->err), "%s out of order or without %d card%s",
+                STREET_NAMES[st], want, want == 1 ? "" : "s");
+            return false;
+        }
+        for (int i = 1; i < ntok; i++)
+            if (!parse_card(strip(tok[i]), &h->board[h->num_board++])) {
+                snprintf(h->err, sizeof(h->err), "bad %s card %s", STREET_NAMES[st], tok[i]);
+                return false;
+            }
+        h->live[st] = ps->in;
+        h->streets = st + 1;
+        memset(ps->bet, 0, sizeof(ps->bet));
+        ps->current = 0;
+        return true;
+    }
+
+    int seat = find_seat(h, tok[0]);
+    if (seat < 0 || ntok < 2) return true;   /* not an action */
+    const char *verb = tok[1];
+    if (strcmp(verb, "posts") == 0 && ntok >= 3) {
+        bet_to(ps, seat, ps->bet[seat] + chips(tok[2]));
+    } else if (strncmp(verb, "folds", 5) == 0) {
+        add_decision(ps, seat, ACT_FOLD, 0);
+        ps->in &= ~(1u << seat);
+    } else if (strncmp(verb, "checks", 6) == 0) {
+        add_decision(ps, seat, ACT_CHECK, 0);
+    } else if (strcmp(verb, "calls") == 0 && ntok >= 3) {
+        add_decision(ps, seat, ACT_CALL, 0);
+        bet_to(ps, seat, ps->bet[seat] + chips(tok[2]));
+    } else if (strcmp(verb, "bets") == 0 && ntok >= 3) {
+        int total = ps->bet[seat] + chips(tok[2]);
+        add_decision(ps, seat, ACT_RAISE, total - ps->current);
+        bet_to(ps, seat, total);
+    } else if (strcmp(verb, "raises") == 0 && ntok >= 4 && strcmp(tok[2], "to") == 0) {
+        int total = chips(tok[3]);
+        add_decision(ps, seat, total > ps->current ? ACT_RAISE : ACT_CALL,
+            total > ps->current ? total - ps->current : 0);
+        bet_to(ps, seat, total);
+    } else if (strcmp(verb, "goes") == 0 && ntok >= 4 && strncmp(tok[2], "all-in", 6) == 0) {
+        int total = chips(tok[3]);
+        add_decision(ps, seat, total > ps->current ? ACT_RAISE : ACT_CALL,
+            total > ps->current ? total - ps->current : 0);
+        bet_to(ps, seat, total);
+    }
+    return true;
+}
+
+/* Checks once the hand is read: distinct cards, at least two players */
+static void finish_hand(hand_t *h)
+{
+    cardmask_t seen = 0;
+    int cards = 0;
+
+    if (h->err[0]) return;
+    if (h->num_seats < 2) {
+        snprintf(h->err, sizeof(h->err), "fewer than two seats");
+        return;
+    }
+    for (int s = 0; s < h->num_seats; s++)
+        if (h->seat[s].known) {
+            seen |= card_bit(h->seat[s].hole[0]) | card_bit(h->seat[s].hole[1]);
+            cards += 2;
+        }
+    seen |= cards_mask(h->board, h->num_board);
+    if (mask_count(seen) != cards + h->num_board)
+        snprintf(h->err, sizeof(h->err), "a card appears twice");
+}
+
+/*
+ * Analysis (workers)
+ */
+
+/* Equity of each known, live seat on street st, ties split */
+static void street_equity(hand_t *h, int st, int runouts, rng_t *rng)
+{
+    int seats[HH_MAX_SEATS], n = 0;
+    cardmask_t hole[HH_MAX_SEATS], dead = cards_mask(h->board, STREET_BOARD[st]);
+    cardmask_t board = dead;
+    double share[HH_MAX_SEATS] = {0};
+
+    for (int s = 0; s < h->num_seats; s++) {
+        if (!h->seat[s].known) continue;
+        cardmask_t m = cards_mask(h->seat[s].hole, 2);
+        dead |= m;
+        if (h->live[st] & (1u << s)) {
+            seats[n] = s;
+            hole[n++] = m;
+        }
+    }
+    if (n < 2) return;
+
+    cardmask_t live = FULL_DECK & ~dead;
+    int k = 5 - STREET_BOARD[st], num_live = mask_count(live);
+    uint8_t deck[DECK_SIZE], pos[DECK_SIZE];
+    int cards[DECK_SIZE], idx[5] = {0, 1, 2, 3, 4}, c = 0;
+    for (cardmask_t m = live; m; m &= m - 1) {
+        pos[__builtin_ctzll(m)] = (uint8_t)c;
+        deck[c] = (uint8_t)__builtin_ctzll(m);
+        cards[c++] = __builtin_ctzll(m);
+    }
+    long total = (st == STREET_PREFLOP) ? runouts : (long)choose(num_live, k);
+
+    for (long r = 0; r < total; r++) {
+        cardmask_t full = board;
+        if (st == STREET_PREFLOP) {
+            for (int i = 0; i < k; i++) full |= deck_draw(deck, pos, num_live, i, rng);
+        } else {
+            for (int i = 0; i < k; i++) full |= 1ULL << cards[idx[i]];
+            int p = k - 1;   /* next k-combination */
+            while (p >= 0 && idx[p] == num_live - k + p) p--;
+            if (p >= 0) {
+                idx[p]++;
+                for (int i = p+1; i < k; i++) idx[i] = idx[i-1] + 1;
+            }
+        }
+
+        board_eval_t be;
+        hand_val_t val[HH_MAX_SEATS], top = 0;
+        int winners = 0;
+        board_prepare(&be, full);
+        for (int i = 0; i < n; i++) {
+            val[i] = board_finish(&be, hole[i]);
+            if (val[i] > top) { top = val[i]; winners = 0; }
+            winners += val[i] == top;
+        }
+        for (int i = 0; i < n; i++)
+            if (val[i] == top) share[i] += 1.0 / winners;
+    }
+    for (int i = 0; i < n; i++) h->seat[seats[i]].equity[st] = share[i] / total;
+}
+
+/* What the advisor makes of one decision, and what it cost */
+static void rate_decision(const pipeline_t *p, hand_t *h, decision_t *d, pa_rng_t *rng)
+{
+    seat_t *s = &h->seat[d->seat];
+    pa_spot_t spot;
+    pa_answer_t ans;
+    char err[128];
+
+    if (!s->known) return;
+    memset(&spot, 0, sizeof(spot));
+    spot.hole[0] = s->hole[0];
+    spot.hole[1] = s->hole[1];
+    spot.num_community = STREET_BOARD[d->street];
+    memcpy(spot.community, h->board, sizeof(card_t) * (size_t)spot.num_community);
+    spot.pot = d->pot;
+    spot.to_call = d->to_call;
+    spot.opponents = d->opponents;
+    spot.threads = 1;
+    if (!pa_advise(p->ctx, &spot, rng, &ans, err, sizeof(err))) return;
+
+    const pa_advice_t *a = &ans.advice;
+    if (d->act == ACT_FOLD) d->ev = 0.0;
+    else if (d->act == ACT_RAISE) d->ev = raise_ev(ans.sim.eq_vs, d->opponents, d->pot, d->to_call, d->raise);
+    else d->ev = a->ev_call;
+    d->best = a->action;
+    d->best_amount = a->amount;
+    d->best_ev = a->ev > d->ev ? a->ev : d->ev;
+    d->rated = true;
+    s->ev_loss += d->best_ev - d->ev;
+    s->decisions++;
+}
+
+static void analyze_hand(const pipeline_t *p, hand_t *h)
+{
+    rng_t rng;
+    pa_rng_t prng;
+
+    for (int s = 0; s < h->num_seats; s++)
+        for (int st = 0; st < NUM_STREETS; st++) h->seat[s].equity[st] = NAN;
+    if (h->err[0]) return;
+    rng_seed(&rng, p->seed + (uint64_t)h->seq);
+    pa_rng_seed(&prng, p->seed + (uint64_t)h->seq);
+    for (int st = 0; st < h->streets; st++) street_equity(h, st, p->runouts, &rng);
+    for (int i = 0; i < h->num_decisions; i++) rate_decision(p, h, &h->decision[i], &prng);
+}
+
+/*
+ * Output (writer)
+ */
+static player_stats_t *player_stats(pipeline_t *p, const char *name)
+{
+    for (int i = 0; i < p->num_players; i++)
+        if (strcmp(p->players[i].name, name) == 0) return &p->players[i];
+    player_stats_t *ps = &p->players[p->num_players < HH_MAX_PLAYERS ? p->num_players++ : HH_MAX_PLAYERS];
+    if (!ps->name[0]) snprintf(ps->name, sizeof(ps->name), "%s",
+                               ps == &p->players[HH_MAX_PLAYERS] ? "(others)" : name);
+    return ps;
+}
+
+/* A JSON string, quoted; ids, names and errors come from the log as written */
+static void print_json_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if (c < 0x20) fprintf(out, "\\u%04x", c);
+        else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+static void write_hand(pipeline_t *p, const hand_t *h)
+{
+    FILE *out = p->out;
+
+    p->hands++;
+    fprintf(out, "{\"hand\":");
+    print_json_string(out, h->id);
+    if (h->err[0]) {
+        fprintf(out, ",\"error\":");
+        print_json_string(out, h->err);
+        fprintf(out, "}\n");
+        p->errors++;
+        return;
+    }
+    fprintf(out, ",\"players\":[");
+    for (int s = 0; s < h->num_seats; s++) {
+        const seat_t *seat = &h->seat[s];
+        fprintf(out, "%s{\"name\":", s ? "," : "");
+        print_json_string(out, seat->name);
+        fprintf(out, ",\"equity\":[");
+        for (int st = 0; st < h->streets; st++) {
+            if (isnan(seat->equity[st])) fprintf(out, "%snull", st ? "," : "");
+            else fprintf(out, "%s%.4f", st ? "," : "", seat->equity[st]);
+        }
+        fprintf(out, "],\"decisions\":%d,\"ev_loss\":%.2f}", seat->decisions, seat->ev_loss);
+
+        player_stats_t *ps = player_stats(p, seat->name);
+        ps->hands++;
+        ps->decisions += seat->decisions;
+        ps->ev_loss += seat->ev_loss;
+    }
+    fprintf(out, "],\"decisions\":[");
+    for (int i = 0, n = 0; i < h->num_decisions; i++) {
+        const decision_t *d = &h->decision[i];
+        if (!d->rated) continue;
+        double loss = d->best_ev - d->ev;
+        fprintf(out, "%s{\"player\":", n++ ? "," : "");
+        print_json_string(out, h->seat[d->seat].name);
+        fprintf(out, ",\"street\":\"%s\",\"action\":\"%s\",\"amount\":%d,"
+            "\"pot\":%d,\"to_call\":%d,\"ev\":%.2f,\"best\":\"%s\",\"best_amount\":%d,"
+            "\"best_ev\":%.2f,\"loss\":%.2f}",
+            STREET_NAMES[d->street], ACT_NAMES[d->act],
+            d->act == ACT_RAISE ? d->raise : d->act == ACT_CALL ? d->to_call : 0,
+            d->pot, d->to_call, d->ev, d->best, d->best_amount, d->best_ev, loss);
+        p->decisions++;
+        p->ev_loss += loss;
+        if (loss >= HH_MISTAKE) {
+            p->mistakes++;
+            player_stats(p, h->seat[d->seat].name)->mistakes++;
+        }
+    }
+    fprintf(out, "]}\n");
+}
+
+static void write_summary(pipeline_t *p)
+{
+    FILE *out = p->out;
+    int n = p->num_players + (p->players[HH_MAX_PLAYERS].hands > 0);
+
+    fprintf(out, "{\"summary\":{\"hands\":%ld,\"errors\":%ld,\"decisions\":%ld,\"mistakes\":%ld,"
+        "\"ev_loss\":%.2f,\"players\":[", p->hands, p->errors, p->decisions, p->mistakes, p->ev_loss);
+    for (int i = 0; i < n; i++) {
+        const player_stats_t *ps = &p->players[i < p->num_players ? i : HH_MAX_PLAYERS];
+        fprintf(out, "%s{\"name\":", i ? "," : "");
+        print_json_string(out, ps->name);
+        fprintf(out, ",\"hands\":%ld,\"decisions\":%ld,\"mistakes\":%ld,"
+            "\"ev_loss\":%.2f,\"ev_loss_per_decision\":%.3f}",
+            ps->hands, ps->decisions, ps->mistakes, ps->ev_loss,
+            ps->decisions ? ps->ev_loss / ps->decisions : 0.0);
+    }
+    fprintf(out, "]}}\n");
+}
+
+/*
+ * Pipeline stages
+ */
+static void *worker_stage(void *arg)
+{
+    pipeline_t *p = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&p->lock);
+        while (p->claimed == p->parsed && !p->eof) pthread_cond_wait(&p->changed, &p->lock);
+        if (p->claimed == p->parsed) {
+            pthread_mutex_unlock(&p->lock);
+            return NULL;
+        }
+        long seq = p->claimed++;
+        pthread_mutex_unlock(&p->lock);
+
+        analyze_hand(p, &p->slot[seq % p->num_slots]);
+
+        pthread_mutex_lock(&p->lock);
+        p->state[seq % p->num_slots] = SLOT_DONE;
+        pthread_cond_broadcast(&p->changed);
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+static void *writer_stage(void *arg)
+{
+    pipeline_t *p = arg;
+
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (!(p->written < p->parsed && p->state[p->written % p->num_slots] == SLOT_DONE) &&
+               !(p->written == p->parsed && p->eof))
+            pthread_cond_wait(&p->changed, &p->lock);
+        if (p->written == p->parsed) break;
+        hand_t *h = &p->slot[p->written % p->num_slots];
+        pthread_mutex_unlock(&p->lock);
+
+        write_hand(p, h);
+
+        pthread_mutex_lock(&p->lock);
+        p->state[p->written++ % p->num_slots] = SLOT_FREE;
+        pthread_cond_broadcast(&p->changed);
+    }
+    pthread_mutex_unlock(&p->lock);
+    write_summary(p);
+    fflush(p->out);
+    return NULL;
+}
+
+/* The next free slot, waiting for the writer if the ring is full */
+static hand_t *reader_slot(pipeline_t *p)
+{
+    pthread_mutex_lock(&p->lock);
+    while (p->state[p->parsed % p->num_slots] != SLOT_FREE) pthread_cond_wait(&p->changed, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+    hand_t *h = &p->slot[p->parsed % p->num_slots];
+    memset(h, 0, sizeof(*h));
+    h->seq = p->parsed;
+    h->streets = 1;
+    return h;
+}
+
+static void reader_submit(pipeline_t *p, hand_t *h)
+{
+    finish_hand(h);
+    h->live[STREET_PREFLOP] = (1u << h->num_seats) - 1;
+    pthread_mutex_lock(&p->lock);
+    p->state[p->parsed++ % p->num_slots] = SLOT_PARSED;
+    pthread_cond_broadcast(&p->changed);
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void reader_stage(pipeline_t *p, FILE *in)
+{
+    char line[HH_LINE_MAX];
+    parse_state_t ps = {0};
+    hand_t *h = NULL;
+
+    while (fgets(line, sizeof(line), in)) {
+        if (strncmp(line, "Hand ", 5) == 0) {
+            if (h) reader_submit(p, h);
+            h = reader_slot(p);
+            memset(&ps, 0, sizeof(ps));
+            ps.h = h;
+            char *id = strip(line + 5 + strspn(line + 5, " #"));
+            id[strcspn(id, " \t\r\n")] = '\0';
+            snprintf(h->id, sizeof(h->id), "%s", id);
+            continue;
+        }
+        if (h && !h->err[0]) parse_line(&ps, line);
+    }
+    if (h) reader_submit(p, h);
+
+    pthread_mutex_lock(&p->lock);
+    p->eof = true;
+    pthread_cond_broadcast(&p->changed);
+    pthread_mutex_unlock(&p->lock);
+}
+
+int main(int argc, char *argv[])
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN), runouts = HH_RUNOUTS;
+    uint64_t seed = 1;
+    const char *path = "-";
+    char err[128];
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--runouts") == 0 && i+1 < argc) runouts = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) path = argv[i];
+        else {
+            fprintf(stderr, "Usage: %s [--threads N] [--runouts N] [--seed S] [log]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if (runouts < 1) runouts = 1;
+
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "Error: cannot open %s.\n", path);
+        return 1;
+    }
+
+    /* One-thread spots with a cache; the preflop table when there is one */
+    pa_config_t cfg;
+    pa_config_default(&cfg);
+    cfg.cache_entries = HH_CACHE;
+    cfg.preflop_table = PREFLOP_FILE;
+    pa_context_t *ctx = pa_context_new(&cfg, err, sizeof(err));
+    if (!ctx) {
+        cfg.preflop_table = NULL;
+        ctx = pa_context_new(&cfg, err, sizeof(err));
+    }
+    if (!ctx) {
+        fprintf(stderr, "Error: %s\n", err);
+        return 1;
+    }
+
+    static pipeline_t p;
+    p.num_slots = 4 * threads + 4;
+    p.slot = malloc(sizeof(hand_t) * (size_t)p.num_slots);
+    p.state = calloc((size_t)p.num_slots, sizeof(int));
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.changed, NULL);
+    p.ctx = ctx;
+    p.seed = seed;
+    p.runouts = runouts;
+    p.out = stdout;
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+
+    /* The reader runs here and blocks on a full ring, so the pipeline */
+    /* needs the writer and at least one worker of its own */
+    pthread_t tids[MAX_THREADS], writer;
+    int started = 0;
+    if (pthread_create(&writer, NULL, writer_stage, &p) != 0) {
+        fprintf(stderr, "Error: cannot start the writer thread.\n");
+        return 1;
+    }
+    for (int t = 0; t < threads; t++, started++)
+        if (pthread_create(&tids[t], NULL, worker_stage, &p) != 0) break;
+    if (started == 0) {
+        fprintf(stderr, "Error: cannot start any analysis thread.\n");
+        return 1;
+    }
+    reader_stage(&p, in);
+    for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+    pthread_join(writer, NULL);
+
+    if (in != stdin) fclose(in);
+    pa_context_free(ctx);
+    free(p.slot);
+    free(p.state);
+    return 0;
+}
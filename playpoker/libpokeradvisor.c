@@ -0,0 +1,2599 @@
+/********************************************************************
+  Author: Vikas Yadav
+  Filename: libpokeradvisor.c
+  Copyright (c) 2017-2026 Vikas Yadav. All rights reserved.
+
+  libpokeradvisor: the hand evaluator, opponent ranges, Monte Carlo and
+  exact equity, the preflop table, outs and the expected-value action
+  solver behind poker_advisor, as a reentrant library. The public API
+  is at the end of this file and declared in pokeradvisor.h; everything
+  else is static, and tools that need the internals (the tests,
+  preflop_table_gen, range_matrix) #include this file directly.
+
+  Build:  gcc -O2 -pthread -c libpokeradvisor.c
+          ar rcs libpokeradvisor.a libpokeradvisor.o
+********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pokeradvisor.h"
+#include "../util/rng.h"
+
+#define DECK_SIZE       52
+#define HAND_SIZE       5
+#define DEFAULT_OPPONENTS 3     /* default table: hero plus 3; --opponents or opponents= */
+#define MAX_OPPONENTS   PA_MAX_OPPONENTS
+#define NUM_SIMULATIONS 10000
+#define EXACT_BUDGET    1000000 /* enumerate when showdowns <= this */
+#define TARGET_SE       0.005   /* default standard error to stop sampling at */
+#define SIM_BATCH       500     /* trials per worker between stopping checks */
+#define SIM_MIN_SAMPLES 1000    /* never judge the standard error on fewer */
+#define SIM_MAX_DROPPED 20      /* ranged deals dropped per capped sample before giving up */
+#define EQUITY_BUCKETS  PA_EQUITY_BUCKETS
+#define SHARE_UNIT      2520    /* a whole pot; splits evenly among 1..10 players */
+#define NUM_RANKS       PA_NUM_RANKS
+#define BIG_BLIND       20
+#define MAX_THREADS     PA_MAX_THREADS
+#define SPOT_MAX_TOKS   32      /* tokens in one spot line */
+#define MAX_CHIPS       1000000000   /* largest pot or call a request may give */
+
+/* The library's own names for the public types */
+typedef pa_card_t   card_t;
+typedef pa_rank_t   rank_t;
+typedef pa_sim_t    sim_result_t;
+typedef pa_outs_t   outs_t;
+typedef pa_advice_t advice_t;
+typedef pa_spot_t   request_t;
+typedef pa_answer_t answer_t;
+
+#define HOLE_CARDS(req)  ((req)->game == PA_GAME_OMAHA ? 4 : 2)
+
+static const char *RANK_NAMES[NUM_RANKS] = {
+    "Royal Flush", "Straight Flush", "Four of a Kind", "Full House",
+    "Flush", "Straight", "Three of a Kind", "Two Pair", "One Pair", "High Card"
+};
+
+/* Face of a rank character like 'A' 'T' '2', or -1 */
+static int parse_face(char ch)
+{
+    switch (ch) {
+        case '2': return 0;
+        case '3': return 1;
+        case '4': return 2;
+        case '5': return 3;
+        case '6': return 4;
+        case '7': return 5;
+        case '8': return 6;
+        case '9': return 7;
+        case 'T': case 't': return 8;
+        case 'J': case 'j': return 9;
+        case 'Q': case 'q': return 10;
+        case 'K': case 'k': return 11;
+        case 'A': case 'a': return 12;
+        default: return -1;
+    }
+}
+
+/* Parse a card string like "Ah" "Tc" "2d" */
+static bool parse_card(const char *s, card_t *c)
+{
+    if ((c->face = parse_face(s[0])) < 0) return false;
+    switch (s[1]) {
+        case 'h': case 'H': c->suit = 0; break;
+        case 's': case 'S': c->suit = 1; break;
+        case 'c': case 'C': c->suit = 2; break;
+        case 'd': case 'D': c->suit = 3; break;
+        default: return false;
+    }
+    return true;
+}
+
+static const char *face_str(int f)
+{
+    static const char *names[] = {"2","3","4","5","6","7","8","9","T","J","Q","K","A"};
+    return names[f];
+}
+
+static char suit_char(int s)
+{
+    return "hscd"[s];
+}
+
+/*
+ * Card sets (hands, boards, dead cards, the live deck) are 52-bit masks
+ * with bit suit*13+face set per card, so each suit's faces form one 13-bit
+ * field and set operations, counting and duplicate checks are single
+ * instructions.
+ */
+typedef uint64_t cardmask_t;
+
+#define FULL_DECK         ((1ULL << DECK_SIZE) - 1)
+#define SUIT_FACES(m, s)  ((unsigned)((m) >> (13 * (s))) & 0x1FFF)
+
+static cardmask_t card_bit(card_t c)
+{
+    return 1ULL << (c.suit * 13 + c.face);
+}
+
+static card_t bit_card(int idx)
+{
+    card_t c = {idx % 13, idx / 13};
+    return c;
+}
+
+static cardmask_t cards_mask(const card_t *cards, int n)
+{
+    cardmask_t m = 0;
+    for (int i = 0; i < n; i++) m |= card_bit(cards[i]);
+    return m;
+}
+
+static int mask_count(cardmask_t m)
+{
+    return __builtin_popcountll(m);
+}
+
+
+/*
+ * Table-driven hand evaluator.
+ *
+ * Every hand is reduced to one comparable integer (hand_val_t, higher is
+ * better) that packs the same fields rank_t carries:
+ *     (9 - rankVal) << 12 | (high+1) << 8 | (high2+1) << 4 | (kicker+1)
+ * so ordering by value is exactly the ordering compare_ranks() has always
+ * used, ties included.
+ *
+ * Flushes are looked up by the 13-bit face mask of the flush suit. With at
+ * most 7 cards, a hand holding 5+ cards of one suit can never make quads
+ * or a full house, so the flush table alone decides those hands; and only
+ * one suit can hold 5 of 7 cards, so the four suit lookups can be OR-ed.
+ *
+ * Everything else depends only on how many cards of each face are held.
+ * Those counts are summed as a base-5 number, 7 low faces and 6 high
+ * faces in separate bit fields (no digit exceeds 4, so sums never carry),
+ * and a perfect hash maps the pair of fields onto a dense index into the
+ * 49205 possible 7-card count vectors. A second hash of the same fields
+ * indexes the 6175 5-card vectors, for Omaha's exact five-card hands.
+ */
+typedef unsigned short hand_val_t;
+
+#define QUIN_LO_FACES   7
+#define QUIN_LO_SIZE    78125       /* 5^7 */
+#define QUIN_HI_SIZE    15625       /* 5^6 */
+#define QUIN_HI_SHIFT   17
+#define QUIN_LO_MASK    0x1FFFF
+#define NUM_NF7         49205       /* 7-card face count vectors */
+#define NUM_NF5         6175        /* 5-card face count vectors */
+
+static unsigned int   quin_key[13];            /* per face, packed base-5 digit */
+static unsigned int   quin_suit[1 << 13];      /* per suit field, sum of its faces' digits */
+static unsigned int   nf_hi_base[QUIN_HI_SIZE];
+static unsigned short nf_lo_rank[QUIN_LO_SIZE];
+static hand_val_t     nf7_val[NUM_NF7];
+static unsigned short nf5_hi_base[QUIN_HI_SIZE];
+static hand_val_t     nf5_val[NUM_NF5];
+static hand_val_t     flush_val[1 << 13];      /* 0 when fewer than 5 bits */
+static uint64_t       bit_quin[64];            /* per card bit: quin_key of its face, and */
+                                               /* 1 in its suit's nibble from bit 32 */
+static unsigned char  suit_size[1 << 13];      /* bits set; popcount is a libcall without -mpopcnt */
+
+static hand_val_t rank_to_val(rank_t r)
+{
+    return (hand_val_t)((9 - r.rankVal) << 12 | (r.high + 1) << 8 |
+                        (r.high2 + 1) << 4 | (r.kicker + 1));
+}
+
+static rank_t val_to_rank(hand_val_t v)
+{
+    rank_t r;
+    r.rankVal = 9 - (v >> 12);
+    r.high    = ((v >> 8) & 15) - 1;
+    r.high2   = ((v >> 4) & 15) - 1;
+    r.kicker  = (v & 15) - 1;
+    return r;
+}
+
+/* Highest face in a 13-bit face mask, -1 if empty */
+static int top_face(unsigned mask)
+{
+    return mask ? 31 - __builtin_clz(mask) : -1;
+}
+
+/* High face of the best straight in a face mask, -1 if none */
+static int straight_high(unsigned mask)
+{
+    for (int h = 12; h >= 4; h--)
+        if (((mask >> (h-4)) & 0x1F) == 0x1F) return h;
+    if ((mask & 0x100F) == 0x100F) return 3;   /* wheel: A-2-3-4-5 */
+    return -1;
+}
+
+/* Best flush or straight flush from the faces of one suit (5+ bits) */
+static hand_val_t flush_value(unsigned mask)
+{
+    rank_t r = {4, -1, -1, -1};
+    int sh = straight_high(mask);
+    if (sh >= 0) {
+        r.rankVal = (sh == 12) ? 0 : 1;
+        r.high = sh;
+    } else {
+        r.high = top_face(mask);
+        r.kicker = top_face(mask & ~(1u << r.high));
+    }
+    return rank_to_val(r);
+}
+
+/* Best non-flush hand from face counts of 5 to 7 cards */
+static hand_val_t counts_value(const int counts[13])
+{
+    rank_t r = {9, -1, -1, -1};
+    int quad = -1, trip = -1, trip2 = -1, pair = -1, pair2 = -1;
+    unsigned mask = 0;
+
+    for (int f = 12; f >= 0; f--) {
+        if (!counts[f]) continue;
+        mask |= 1u << f;
+        if (counts[f] == 4)      quad = f;
+        else if (counts[f] == 3) { if (trip < 0) trip = f; else trip2 = f; }
+        else if (counts[f] == 2) { if (pair < 0) pair = f; else if (pair2 < 0) pair2 = f; }
+    }
+
+    if (quad >= 0) {
+        r.rankVal = 2; r.high = quad;
+        r.kicker = top_face(mask & ~(1u << quad));
+    } else if (trip >= 0 && (trip2 >= 0 || pair >= 0)) {
+        r.rankVal = 3; r.high = trip;
+        r.high2 = r.kicker = (trip2 > pair) ? trip2 : pair;
+    } else if (straight_high(mask) >= 0) {
+        r.rankVal = 5; r.high = straight_high(mask);
+    } else if (trip >= 0) {
+        r.rankVal = 6; r.high = trip;
+        r.kicker = top_face(mask & ~(1u << trip));
+    } else if (pair2 >= 0) {
+        r.rankVal = 7; r.high = pair; r.high2 = pair2;
+        r.kicker = top_face(mask & ~(1u << pair) & ~(1u << pair2));
+    } else if (pair >= 0) {
+        r.rankVal = 8; r.high = pair;
+        r.kicker = top_face(mask & ~(1u << pair));
+    } else {
+        r.high = top_face(mask);
+        r.high2 = top_face(mask & ~(1u << r.high));
+        r.kicker = top_face(mask & ~(1u << r.high) & ~(1u << r.high2));
+    }
+    return rank_to_val(r);
+}
+
+/* Fill nf7_val[] or nf5_val[] for every count vector of that many cards,
+   recursing over faces */
+static void fill_nf(int counts[13], int face, int left, unsigned key, int cards)
+{
+    if (face == 13) {
+        if (left == 0 && cards == 7)
+            nf7_val[nf_hi_base[key >> QUIN_HI_SHIFT] + nf_lo_rank[key & QUIN_LO_MASK]] =
+                counts_value(counts);
+        else if (left == 0)
+            nf5_val[nf5_hi_base[key >> QUIN_HI_SHIFT] + nf_lo_rank[key & QUIN_LO_MASK]] =
+                counts_value(counts);
+        return;
+    }
+    for (int c = 0; c <= 4 && c <= left; c++) {
+        counts[face] = c;
+        fill_nf(counts, face+1, left-c, key + c * quin_key[face], cards);
+    }
+    counts[face] = 0;
+}
+
+/* Build the lookup tables, once: see eval_init() */
+static void eval_build(void)
+{
+    int lo_count[8] = {0};
+    int counts[13] = {0};
+    unsigned p = 1, base = 0, base5 = 0;
+
+    for (int f = 0; f < 13; f++) {
+        if (f == QUIN_LO_FACES) p = 1;
+        quin_key[f] = (f < QUIN_LO_FACES) ? p : p << QUIN_HI_SHIFT;
+        p *= 5;
+    }
+
+    /* Rank each low field among those with the same digit sum, then give
+       each high field the base offset of its block of low fields. */
+    for (int lo = 0; lo < QUIN_LO_SIZE; lo++) {
+        int s = 0;
+        for (int x = lo; x; x /= 5) s += x % 5;
+        if (s <= 7) nf_lo_rank[lo] = (unsigned short)lo_count[s]++;
+    }
+    for (int hi = 0; hi < QUIN_HI_SIZE; hi++) {
+        int s = 0;
+        for (int x = hi; x; x /= 5) s += x % 5;
+        if (s <= 7) { nf_hi_base[hi] = base; base += lo_count[7 - s]; }
+        if (s <= 5) { nf5_hi_base[hi] = (unsigned short)base5; base5 += lo_count[5 - s]; }
+    }
+    fill_nf(counts, 0, 7, 0, 7);
+    fill_nf(counts, 0, 5, 0, 5);
+
+    for (unsigned m = 0; m < (1u << 13); m++) {
+        suit_size[m] = (unsigned char)__builtin_popcount(m);
+        flush_val[m] = (suit_size[m] >= 5) ? flush_value(m) : 0;
+        quin_suit[m] = 0;
+        for (int f = 0; f < 13; f++)
+            if (m & (1u << f)) quin_suit[m] += quin_key[f];
+    }
+    for (int c = 0; c < DECK_SIZE; c++)
+        bit_quin[c] = quin_key[c % 13] | (1ULL << (32 + 4 * (c / 13)));
+}
+
+/* Call before evaluating any hand; safe from any number of threads */
+static void eval_init(void)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, eval_build);
+}
+
+/* Value of exactly 7 cards */
+static inline hand_val_t eval7(cardmask_t m)
+{
+    unsigned s0 = SUIT_FACES(m, 0), s1 = SUIT_FACES(m, 1);
+    unsigned s2 = SUIT_FACES(m, 2), s3 = SUIT_FACES(m, 3);
+    hand_val_t f = flush_val[s0] | flush_val[s1] | flush_val[s2] | flush_val[s3];
+
+    if (f) return f;
+    unsigned key = quin_suit[s0] + quin_suit[s1] + quin_suit[s2] + quin_suit[s3];
+    return nf7_val[nf_hi_base[key >> QUIN_HI_SHIFT] + nf_lo_rank[key & QUIN_LO_MASK]];
+}
+
+/*
+ * A board of five cards, ranked once so each holding on it costs only its
+ * two hole cards: two key additions and one flush lookup. Only a suit with
+ * 3+ board cards can make a flush; without one, flush_sel is 0 and the
+ * lookup lands on flush_val[0] = 0. Worth it where one board serves many
+ * holdings (exact enumeration, range_matrix); a Monte Carlo trial scores
+ * too few hands on its board to repay the setup.
+ */
+typedef struct {
+    uint64_t   key;           /* packed face counts of the board, and from */
+                              /* bit 32 its cards per suit, a nibble each */
+    unsigned   flush_faces;   /* board faces in the flush suit */
+    int        flush_shift;   /* 13 * flush suit */
+    unsigned   flush_sel;     /* 0x1FFF if a flush is possible, else 0 */
+} board_eval_t;
+
+static void board_prepare(board_eval_t *b, cardmask_t board)
+{
+    b->key = 0;
+    for (int s = 0; s < 4; s++)
+        b->key += quin_suit[SUIT_FACES(board, s)] |
+                  ((uint64_t)suit_size[SUIT_FACES(board, s)] << (32 + 4 * s));
+
+    unsigned three = ((unsigned)(b->key >> 32) + 0x5555) & 0x8888;   /* nibbles of 3+ */
+    int s = three ? __builtin_ctz(three) / 4 : 0;
+
+    b->flush_shift = 13 * s;
+    b->flush_sel = three ? 0x1FFF : 0;
+    b->flush_faces = SUIT_FACES(board, s) & b->flush_sel;
+}
+
+/* Value of the board plus two hole cards; same as eval7(board | hole) */
+static inline hand_val_t board_finish(const board_eval_t *b, cardmask_t hole)
+{
+    unsigned key = (unsigned)(b->key + bit_quin[__builtin_ctzll(hole)] + bit_quin[63 - __builtin_clzll(hole)]);
+    hand_val_t nf = nf7_val[nf_hi_base[key >> QUIN_HI_SHIFT] + nf_lo_rank[key & QUIN_LO_MASK]];
+    hand_val_t f = flush_val[b->flush_faces | ((unsigned)(hole >> b->flush_shift) & b->flush_sel)];
+    return f > nf ? f : nf;
+}
+
+/*
+ * Omaha: the best hand from exactly two of four hole cards and three of
+ * the board. Going through all 6 x 10 five-card hands with best_hand()
+ * is 60 evaluations per player. Instead a board is prepared once: the
+ * packed face counts of each distinct triple of its cards, and the faces
+ * of each triple in the one suit that can flush (a five-card board has
+ * at most one suit with three cards). A hole pair then costs one 5-card
+ * lookup per triple, nf5_val[triple + pair], plus flush lookups when
+ * both its cards are in that suit. The best non-flush value of each
+ * pair of hole faces is kept in the board's pair_val[] the first time it
+ * is needed, so every later holding with those faces (and exact
+ * enumeration meets each one thousands of times) costs a single load.
+ * A flush always outranks the same five faces unsuited, so the larger
+ * of the two values is the hand's.
+ */
+typedef struct {
+    int        num_triples;
+    unsigned   key[10];            /* packed face counts of each distinct triple */
+    int        num_flush;          /* triples in the flush suit */
+    unsigned   flush_faces[10];
+    int        flush_shift;        /* 13 * that suit */
+    hand_val_t pair_val[13][13];   /* best non-flush value by hole faces, 0: not yet */
+} omaha_board_t;
+
+/* Prepare a board of 3 to 5 cards */
+static void omaha_prepare(omaha_board_t *b, cardmask_t board)
+{
+    int card[5], n = 0;
+    for (cardmask_t m = board; m; m &= m - 1) card[n++] = __builtin_ctzll(m);
+
+    b->num_triples = b->num_flush = 0;
+    b->flush_shift = 0;
+    for (int i = 0; i < n; i++)
+        for (int j = i+1; j < n; j++)
+            for (int k = j+1; k < n; k++) {
+                unsigned key = quin_key[card[i] % 13] + quin_key[card[j] % 13] + quin_key[card[k] % 13];
+                int t = 0;
+                while (t < b->num_triples && b->key[t] != key) t++;
+                if (t == b->num_triples) b->key[b->num_triples++] = key;
+                if (card[i] / 13 == card[j] / 13 && card[j] / 13 == card[k] / 13) {
+                    b->flush_shift = 13 * (card[i] / 13);
+                    b->flush_faces[b->num_flush++] =
+                        1u << (card[i] % 13) | 1u << (card[j] % 13) | 1u << (card[k] % 13);
+                }
+            }
+    memset(b->pair_val, 0, sizeof(b->pair_val));
+}
+
+/* Value of four hole cards on a prepared board */
+static inline hand_val_t omaha_finish(omaha_board_t *b, cardmask_t hole)
+{
+    int face[4], n = 0;
+    hand_val_t best = 0;
+
+    for (cardmask_t m = hole; m; m &= m - 1) face[n++] = __builtin_ctzll(m) % 13;
+    for (int i = 0; i < 4; i++)
+        for (int j = i+1; j < 4; j++) {
+            hand_val_t *v = &b->pair_val[face[i]][face[j]];
+            if (!*v) {
+                unsigned pair = quin_key[face[i]] + quin_key[face[j]];
+                for (int t = 0; t < b->num_triples; t++) {
+                    unsigned key = b->key[t] + pair;
+                    hand_val_t nf = nf5_val[nf5_hi_base[key >> QUIN_HI_SHIFT] + nf_lo_rank[key & QUIN_LO_MASK]];
+                    if (nf > *v) *v = nf;
+                }
+                b->pair_val[face[j]][face[i]] = *v;
+            }
+            if (*v > best) best = *v;
+        }
+
+    /* Flushes: two hole cards in the board's flush suit */
+    unsigned suited = b->num_flush ? (unsigned)(hole >> b->flush_shift) & 0x1FFF : 0;
+    for (unsigned a = suited; a; a &= a - 1)
+        for (unsigned c = a & (a - 1); c; c &= c - 1) {
+            unsigned pair = (a & -a) | (c & -c);
+            for (int t = 0; t < b->num_flush; t++)
+                if (flush_val[b->flush_faces[t] | pair] > best) best = flush_val[b->flush_faces[t] | pair];
+        }
+    return best;
+}
+
+/* Value of the best 5-card hand within 5 to 7 cards */
+static hand_val_t eval_mask(cardmask_t m)
+{
+    if (mask_count(m) == 7) return eval7(m);
+
+    hand_val_t f = flush_val[SUIT_FACES(m, 0)] | flush_val[SUIT_FACES(m, 1)] |
+                   flush_val[SUIT_FACES(m, 2)] | flush_val[SUIT_FACES(m, 3)];
+    if (f) return f;
+
+    int counts[13];
+    for (int face = 0; face < 13; face++)
+        counts[face] = (int)((m >> face) & 1) + (int)((m >> (13+face)) & 1) +
+                       (int)((m >> (26+face)) & 1) + (int)((m >> (39+face)) & 1);
+    return counts_value(counts);
+}
+
+/* Compare two ranks: returns >0 if a wins, <0 if b wins, 0 if tie */
+static inline int compare_ranks(rank_t *a, rank_t *b)
+{
+    int va = (9 - a->rankVal) * 4096 + (a->high + 1) * 256 + (a->high2 + 1) * 16 + (a->kicker + 1);
+    int vb = (9 - b->rankVal) * 4096 + (b->high + 1) * 256 + (b->high2 + 1) * 16 + (b->kicker + 1);
+    return (va > vb) - (va < vb);
+}
+
+/* Evaluate best 5 of N cards (N=5,6,7) */
+static rank_t best_hand(cardmask_t cards)
+{
+    if (mask_count(cards) < 5) {
+        rank_t none = {10, -1, -1, -1};
+        return none;
+    }
+    return val_to_rank(eval_mask(cards));
+}
+
+/*
+ * Omaha the plain way: best_hand() on every two hole cards with every
+ * three board cards. The reference omaha_finish() is checked and timed
+ * against.
+ */
+static rank_t omaha_best_hand(cardmask_t hole, cardmask_t board)
+{
+    rank_t best = {10, -1, -1, -1};
+    for (cardmask_t a = hole; a; a &= a - 1)
+        for (cardmask_t b = a & (a - 1); b; b &= b - 1)
+            for (cardmask_t c = board; c; c &= c - 1)
+                for (cardmask_t d = c & (c - 1); d; d &= d - 1)
+                    for (cardmask_t e = d & (d - 1); e; e &= e - 1) {
+                        rank_t r = best_hand((a & -a) | (b & -b) | (c & -c) | (d & -d) | (e & -e));
+                        if (compare_ranks(&r, &best) > 0) best = r;
+                    }
+    return best;
+}
+
+/*
+ * Draw the i-th card of a partial Fisher-Yates shuffle over the n bit
+ * positions in deck[]; positions before i are the cards already drawn.
+ * pos[] is the inverse permutation, kept so deck_take() can find a card.
+ */
+static inline cardmask_t deck_draw(uint8_t *deck, uint8_t *pos, int n, int i, rng_t *rng)
+{
+    int j = i + (int)rng_bounded(rng, (uint32_t)(n - i));
+    uint8_t a = deck[j], b = deck[i];
+    deck[i] = a; pos[a] = (uint8_t)i;
+    deck[j] = b; pos[b] = (uint8_t)j;
+    return 1ULL << a;
+}
+
+/*
+ * Opponent ranges.
+ *
+ * A range weights each of the 1326 two-card holdings. It is written in
+ * the usual notation as comma-separated items: pairs "QQ", "QQ+", "TT-77";
+ * suited or offsuit hands "AKs", "ATo+", "K9s-K6s", "AK" (both); exact
+ * holdings "AhKd"; "random"; or "top15%", the best 15% of holdings by
+ * Chen score. An item may carry a weight in (0, 1], e.g. "AQs:0.5".
+ */
+#define NUM_COMBOS      1326
+#define RANGE_SPEC_MAX  256
+
+typedef struct {
+    float weight[NUM_COMBOS];   /* by holding_index(); 0 = not in the range */
+} range_t;
+
+/* Holding index of the cards at bit positions a < b */
+static int holding_index(int a, int b)
+{
+    return a * (2*DECK_SIZE - a - 1) / 2 + (b - a - 1);
+}
+
+/* Give every holding of a starting hand the weight w; suited < 0 means either */
+static void range_add_class(range_t *r, int hi, int lo, int suited, float w)
+{
+    for (int s1 = 0; s1 < 4; s1++)
+        for (int s2 = 0; s2 < 4; s2++) {
+            if (hi == lo ? s2 <= s1 : (suited == 1 && s1 != s2) || (suited == 0 && s1 == s2))
+                continue;
+            int a = s1*13 + hi, b = s2*13 + lo;
+            r->weight[a < b ? holding_index(a, b) : holding_index(b, a)] = w;
+        }
+}
+
+/* Chen formula score of a starting hand, doubled so halves stay integral */
+static int chen_score2(int hi, int lo, bool suited)
+{
+    static const int high2[13] = {2, 3, 4, 5, 6, 7, 8, 9, 10, 12, 14, 16, 20};
+    static const int gap2[5] = {0, 2, 4, 8, 10};
+    int s = high2[hi], gap = hi - lo - 1;
+
+    if (hi == lo) return (s * 2 < 10) ? 10 : s * 2;
+    if (suited) s += 4;
+    s -= gap2[gap < 4 ? gap : 4];
+    if (gap <= 1 && hi < 10) s += 2;   /* connected, both below a queen */
+    return s;
+}
+
+/* Add the best pct percent of holdings, whole starting hands at a time */
+static void range_add_top(range_t *r, double pct, float w)
+{
+    int order[13*13], score[13*13];
+
+    for (int c = 0; c < 13*13; c++) {
+        int row = c / 13, col = c % 13;
+        int hi = row > col ? row : col, lo = row > col ? col : row;
+        order[c] = c;
+        score[c] = chen_score2(hi, lo, row > col);
+    }
+    /* Insertion sort, best first; ties keep the higher cards first */
+    for (int i = 1; i < 13*13; i++)
+        for (int j = i; j > 0 && score[order[j]] > score[order[j-1]]; j--) {
+            int t = order[j]; order[j] = order[j-1]; order[j-1] = t;
+        }
+
+    int taken = 0;
+    for (int k = 0; k < 13*13 && taken < pct / 100.0 * NUM_COMBOS; k++) {
+        int c = order[k], row = c / 13, col = c % 13;
+        int hi = row > col ? row : col, lo = row > col ? col : row;
+        range_add_class(r, hi, lo, row > col, w);
+        taken += (hi == lo) ? 6 : (row > col) ? 4 : 12;
+    }
+}
+
+/* Add one item of range notation; returns false with a message in err */
+static bool range_add_item(range_t *r, char *item, char *err, size_t errlen)
+{
+    float w = 1.0f;
+    char *colon = strchr(item, ':');
+    card_t c1, c2;
+
+    if (colon) {
+        *colon = '\0';
+        w = (float)atof(colon + 1);
+        if (!(w > 0.0f && w <= 1.0f)) {
+            snprintf(err, errlen, "range weight must be in (0, 1] in %s.", item);
+            return false;
+        }
+    }
+    size_t len = strlen(item);
+
+    if (strcmp(item, "random") == 0 || strcmp(item, "any") == 0) {
+        for (int i = 0; i < NUM_COMBOS; i++) r->weight[i] = w;
+        return true;
+    }
+    if (len > 1 && item[len-1] == '%') {
+        double pct = atof(strncmp(item, "top", 3) == 0 ? item + 3 : item);
+        if (!(pct > 0.0 && pct <= 100.0)) {
+            snprintf(err, errlen, "range percentage must be in (0, 100] in %s.", item);
+            return false;
+        }
+        range_add_top(r, pct, w);
+        return true;
+    }
+    if (len == 4 && parse_card(item, &c1) && parse_card(item + 2, &c2)) {
+        int a = c1.suit*13 + c1.face, b = c2.suit*13 + c2.face;
+        if (a == b) {
+            snprintf(err, errlen, "range holding %s repeats a card.", item);
+            return false;
+        }
+        r->weight[a < b ? holding_index(a, b) : holding_index(b, a)] = w;
+        return true;
+    }
+
+    /* Starting hand, then an optional "+" or "-" and a second hand */
+    int f1 = parse_face(item[0]), f2 = (len > 1) ? parse_face(item[1]) : -1;
+    int suited = -1;
+    const char *p = item + 2;
+    if (f1 < 0 || f2 < 0) goto bad;
+    if (*p == 's' || *p == 'o') {
+        if (f1 == f2) goto bad;
+        suited = (*p++ == 's');
+    }
+    int hi = f1 > f2 ? f1 : f2, lo = f1 > f2 ? f2 : f1;
+    int from = lo, to = lo;   /* lower card span (both cards for pairs) */
+
+    if (*p == '+') {
+        to = (hi == lo) ? 12 : hi - 1;
+        p++;
+    } else if (*p == '-') {
+        int g1 = parse_face(p[1]), g2 = (g1 >= 0) ? parse_face(p[2]) : -1;
+        if (g1 < 0 || g2 < 0 || (hi == lo) != (g1 == g2) || (hi != lo && g1 != hi && g2 != hi))
+            goto bad;
+        int end = (hi == lo) ? g1 : (g1 == hi ? g2 : g1);
+        p += 3;
+        if (hi != lo && (*p == 's' || *p == 'o')) {
+            if ((*p == 's') != (suited == 1) || suited < 0) goto bad;
+            p++;
+        }
+        from = lo < end ? lo : end;
+        to = lo < end ? end : lo;
+        if (hi != lo && to >= hi) goto bad;
+    }
+    if (*p != '\0') goto bad;
+    for (int f = from; f <= to; f++)
+        range_add_class(r, (hi == lo) ? f : hi, f, suited, w);
+    return true;
+
+bad:
+    snprintf(err, errlen, "invalid range item %s.", item);
+    return false;
+}
+
+/*
+ * Parse a range for each opponent: items separated by commas, ranges by
+ * "/" (e.g. "QQ+,AKs/top20%"). The last range is repeated for opponents
+ * beyond those given. Returns the number of ranges, or 0 with a message
+ * in err.
+ */
+static int range_parse(range_t ranges[MAX_OPPONENTS], const char *spec, char *err, size_t errlen)
+{
+    char buf[RANGE_SPEC_MAX], *save = NULL;
+    int n = 0;
+
+    if (strlen(spec) >= sizeof(buf)) {
+        snprintf(err, errlen, "range is too long.");
+        return 0;
+    }
+    strcpy(buf, spec);
+    for (char *part = strtok_r(buf, "/", &save); part; part = strtok_r(NULL, "/", &save)) {
+        char *isave = NULL;
+        bool any = false;
+
+        if (n == MAX_OPPONENTS) {
+            snprintf(err, errlen, "at most %d ranges.", MAX_OPPONENTS);
+            return 0;
+        }
+        memset(&ranges[n], 0, sizeof(range_t));
+        for (char *item = strtok_r(part, ", ", &isave); item; item = strtok_r(NULL, ", ", &isave)) {
+            if (!range_add_item(&ranges[n], item, err, errlen)) return 0;
+            any = true;
+        }
+        if (!any) {
+            snprintf(err, errlen, "empty range.");
+            return 0;
+        }
+        n++;
+    }
+    if (n == 0) snprintf(err, errlen, "empty range.");
+    return n;
+}
+
+/*
+ * Walker's alias table over the holdings of a range that avoid the known
+ * cards, so one holding is drawn in O(1) with a single RNG call.
+ */
+typedef struct {
+    int        n;
+    cardmask_t combo[NUM_COMBOS];
+    uint32_t   cut[NUM_COMBOS];      /* keep combo[i] when the coin is below this */
+    uint16_t   alias[NUM_COMBOS];
+} alias_t;
+
+/* Build with Vose's method; false if no holding of the range is possible */
+static bool alias_build(alias_t *t, const range_t *r, cardmask_t dead)
+{
+    double p[NUM_COMBOS], total = 0.0;
+    int small[NUM_COMBOS], large[NUM_COMBOS], ns = 0, nl = 0;
+
+    t->n = 0;
+    for (int a = 0; a < DECK_SIZE; a++)
+        for (int b = a+1; b < DECK_SIZE; b++) {
+            cardmask_t m = (1ULL << a) | (1ULL << b);
+            float w = r->weight[holding_index(a, b)];
+            if (w <= 0.0f || (m & dead)) continue;
+            t->combo[t->n] = m;
+            p[t->n] = w;
+            total += w;
+            t->n++;
+        }
+    if (t->n == 0) return false;
+
+    for (int i = 0; i < t->n; i++) {
+        p[i] = p[i] * t->n / total;
+        if (p[i] < 1.0) small[ns++] = i; else large[nl++] = i;
+    }
+    while (ns > 0 && nl > 0) {
+        int s = small[--ns], l = large[--nl];
+        t->cut[s] = (uint32_t)(p[s] * 4294967296.0);
+        t->alias[s] = (uint16_t)l;
+        p[l] -= 1.0 - p[s];
+        if (p[l] < 1.0) small[ns++] = l; else large[nl++] = l;
+    }
+    /* Whatever is left is 1 up to rounding */
+    while (nl > 0) { int l = large[--nl]; t->cut[l] = UINT32_MAX; t->alias[l] = (uint16_t)l; }
+    while (ns > 0) { int s = small[--ns]; t->cut[s] = UINT32_MAX; t->alias[s] = (uint16_t)s; }
+    return true;
+}
+
+/*
+ * The high half of the draw picks a column (multiply-shift, bias below
+ * n/2^32), the low half is the coin between it and its alias.
+ */
+static cardmask_t alias_draw(const alias_t *t, rng_t *rng)
+{
+    uint64_t x = rng_next(rng);
+    uint32_t i = (uint32_t)(((x >> 32) * (uint64_t)t->n) >> 32);
+    return ((uint32_t)x < t->cut[i]) ? t->combo[i] : t->combo[t->alias[i]];
+}
+
+/* Simulation settings */
+typedef struct {
+    int      opponents;     /* random opponent hands, 1..MAX_OPPONENTS */
+    int      trials;        /* Monte Carlo sample cap */
+    int      threads;       /* worker threads, 1..MAX_THREADS */
+    uint64_t seed;          /* master RNG seed */
+    double   exact_budget;  /* enumerate exactly when outcomes <= this (0: never) */
+    double   target_se;     /* stop once the equity's standard error is this small (0: off) */
+    double   max_ms;        /* stop after this much wall time (0: no limit) */
+    const range_t *ranges;  /* opponent i holds ranges[min(i, num_ranges-1)] */
+    int      num_ranges;    /* 0: every opponent holds a random hand */
+    int      hist_samples;  /* nested samples per trial for the next-street */
+                            /* equity histogram (0: off) */
+    bool     stratified;    /* sample every runout stratum in turn (see run_trials()) */
+    const int *stacks;      /* chips still to go in, hero then each opponent, */
+                            /* all-in: side pots (see pots_build()); NULL: none */
+    int      pot;           /* with stacks: dead money in the main pot */
+    bool     omaha;         /* four hole cards each, exactly two used */
+} sim_opts_t;
+
+static sim_opts_t sim_opts_default(void)
+{
+    sim_opts_t o = {DEFAULT_OPPONENTS, NUM_SIMULATIONS, 1, 0, EXACT_BUDGET, TARGET_SE, 0.0, NULL, 0, 0, false, NULL, 0, false};
+    return o;
+}
+
+/* Trials and pot-share totals in one stratum (SHARE_UNIT units) */
+typedef struct {
+    long n, sum, sq;
+} stratum_t;
+
+/*
+ * Side pots the hero can win, main pot first. Pot j holds what every
+ * player put in between levels j-1 and j, the main pot also the dead
+ * money; opponent i is in pots 1..in[i] (pot 0 is unused).
+ */
+typedef struct {
+    int    num;
+    double amount[MAX_OPPONENTS + 2];
+    int    in[MAX_OPPONENTS];
+} pots_t;
+
+/*
+ * One worker's share of the work. For Monte Carlo each worker draws its
+ * own cards from the live deck; for exact enumeration it takes every
+ * nthreads-th board completion.
+ */
+typedef struct sim_worker {
+    void        (*run)(struct sim_worker *);
+    cardmask_t    hole;
+    cardmask_t    board;          /* known community cards */
+    int           num_community;
+    cardmask_t    live;           /* cards neither held nor on the board */
+    int           num_live;
+    uint8_t       deck[DECK_SIZE];  /* bit positions of the live cards */
+    uint8_t       pos[DECK_SIZE];   /* index in deck[] of each bit position */
+    int           opponents;
+    bool          omaha;          /* four hole cards each (see omaha_finish()) */
+    const alias_t *range[MAX_OPPONENTS];   /* NULL: a random hand */
+    bool          ranged;         /* any opponent holds a range */
+    int           trials;
+    int           index, nthreads;
+    rng_t         rng;
+    long          score;          /* pot shares won, SHARE_UNIT units */
+    long          score_sq;       /* and their squares, per trial */
+    long          outcomes;
+    long          evals;
+    long          dropped;
+    int           hist_samples;   /* nested samples per trial, 0: no histogram */
+    int           street;         /* cards on the next street */
+    long          hist[EQUITY_BUCKETS];
+    double        hist_sum, hist_sq;
+    int           reached;        /* last showdown: first opponent to beat the hero */
+    uint32_t      tied;           /* and those before it who tied, a bit each */
+    const pots_t *pots;           /* NULL: one pot, no stacks */
+    double        won;            /* last showdown: chips the hero took from pots */
+    double        chips;          /* summed over trials */
+    long          prefix[MAX_OPPONENTS + 1];   /* trial scores against the first */
+                                /* k opponents, differenced over k-1 (see tally_prefix()) */
+    long          deals[MAX_OPPONENTS + 1][MAX_OPPONENTS + 1];   /* exact: showdowns */
+                                /* by opponents beaten and tied */
+    const cardmask_t *strata;     /* stratified: each stratum's runout, shared */
+    int           num_strata;     /* 0: plain sampling */
+    stratum_t    *tally;          /* this worker's trials by stratum */
+    uint16_t     *order;          /* this cycle's order of the strata */
+    int           cycle_pos;      /* next place in order[] */
+} sim_worker_t;
+
+/* Move the card at bit position c to deck[i], tracking positions in pos[] */
+static void deck_take(uint8_t *deck, uint8_t *pos, int i, int c)
+{
+    int j = pos[c];
+    deck[j] = deck[i]; pos[deck[j]] = (uint8_t)j;
+    deck[i] = (uint8_t)c; pos[c] = (uint8_t)i;
+}
+
+/* Move cards to deck[*drawn] onward, out of the way of later draws */
+static void take_cards(sim_worker_t *w, cardmask_t cards, int *drawn)
+{
+    for (; cards; cards &= cards - 1)
+        deck_take(w->deck, w->pos, (*drawn)++, __builtin_ctzll(cards));
+}
+
+/*
+ * Deal every ranged opponent from its alias table and take the cards out
+ * of the deck. Fails, taking nothing, when two holdings share a card or
+ * one holds a card in avoid.
+ */
+static bool deal_ranged(sim_worker_t *w, cardmask_t *opp_hole, cardmask_t avoid, int *drawn)
+{
+    cardmask_t taken = 0;
+    bool clash = false;
+    for (int opp = 0; opp < w->opponents; opp++) {
+        if (!w->range[opp]) continue;
+        opp_hole[opp] = alias_draw(w->range[opp], &w->rng);
+        clash |= (opp_hole[opp] & (taken | avoid)) != 0;
+        taken |= opp_hole[opp];
+    }
+    if (clash) return false;
+    take_cards(w, taken, drawn);
+    return true;
+}
+
+/*
+ * Build the side pots from each player's chips still to go in: one pot
+ * per distinct level up to the hero's, as the game's buildSidePots()
+ * does. Chips above every other player's level come back to the hero as
+ * a pot only the hero is in.
+ */
+static void pots_build(pots_t *p, const int *stacks, int opponents, int dead)
+{
+    int level[MAX_OPPONENTS + 2], num = 0;
+
+    level[num++] = 0;
+    for (int i = 0; i <= opponents; i++) {
+        int c = stacks[i] < stacks[0] ? stacks[i] : stacks[0];
+        int j = num;
+        while (j > 1 && level[j-1] > c) j--;
+        if (level[j-1] == c) continue;
+        memmove(&level[j+1], &level[j], sizeof(int) * (size_t)(num - j));
+        level[j] = c;
+        num++;
+    }
+    memset(p, 0, sizeof(*p));
+    p->num = num - 1;
+    for (int j = 1; j < num; j++) {
+        for (int i = 0; i <= opponents; i++) {
+            int c = stacks[i];
+            if (c > level[j-1]) p->amount[j] += (c < level[j] ? c : level[j]) - level[j-1];
+        }
+        for (int i = 0; i < opponents; i++)
+            if (stacks[i+1] >= level[j]) p->in[i] = j;
+    }
+    p->amount[1] += dead;
+}
+
+/*
+ * Chips the hero takes from the pots: nothing from pots 1..lost (an
+ * opponent in them beat the hero), the rest split with the opponents
+ * who tied in each. tied_in[j] counts ties whose last pot is j.
+ */
+static inline double pots_won(const pots_t *p, int lost, int *tied_in)
+{
+    double won = 0.0;
+    int ties = 0;
+    for (int j = p->num; j > lost; j--) {
+        ties += tied_in[j];
+        won += p->amount[j] / (1 + ties);
+    }
+    return won;
+}
+
+/*
+ * Finish a deal whose ranged holdings are in opp_hole: draw the rest of
+ * the board from deck[drawn] on, then random opponents until one beats
+ * the hero. Returns the hero's share of the pot in SHARE_UNIT units: a
+ * whole one for a win, split evenly when others tie, 0 for a loss. Where
+ * the hero lost goes in w->reached and who tied before then in w->tied.
+ *
+ * With side pots (w->pots) a loss settles only the pots that opponent is
+ * in, so every opponent is dealt and ranked, and w->won gets the chips
+ * the hero takes. That costs the early exit, so only stacked spots pay.
+ */
+static inline int showdown_game(sim_worker_t *w, cardmask_t board, int to_draw,
+                                const cardmask_t *opp_hole, int n, int drawn, const bool omaha)
+{
+    for (int i = 0; i < to_draw; i++)
+        board |= deck_draw(w->deck, w->pos, n, drawn++, &w->rng);
+
+    /* Player's best hand */
+    omaha_board_t ob;
+    if (omaha) omaha_prepare(&ob, board);
+    hand_val_t player_val = omaha ? omaha_finish(&ob, w->hole) : eval7(w->hole | board);
+    w->evals++;
+
+    /* Opponents' hands */
+    int reached = w->opponents, lost = 0;
+    int tied_in[MAX_OPPONENTS + 2] = {0};
+    uint32_t tied = 0;
+    for (int opp = 0; opp < w->opponents; opp++) {
+        cardmask_t hole = opp_hole[opp];
+        if (!w->range[opp]) {
+            hole = deck_draw(w->deck, w->pos, n, drawn++, &w->rng);
+            hole |= deck_draw(w->deck, w->pos, n, drawn++, &w->rng);
+            if (omaha) {
+                hole |= deck_draw(w->deck, w->pos, n, drawn++, &w->rng);
+                hole |= deck_draw(w->deck, w->pos, n, drawn++, &w->rng);
+            }
+        }
+        hand_val_t opp_val = omaha ? omaha_finish(&ob, hole) : eval7(hole | board);
+        w->evals++;
+        if (player_val < opp_val) {
+            if (reached == w->opponents) reached = opp;
+            if (!w->pots) break;
+            if (w->pots->in[opp] > lost) lost = w->pots->in[opp];
+        } else if (player_val == opp_val) {
+            if (reached == w->opponents) tied |= 1u << opp;
+            if (w->pots) tied_in[w->pots->in[opp]]++;
+        }
+    }
+    w->reached = reached;
+    w->tied = tied;
+    if (w->pots) w->won = pots_won(w->pots, lost, tied_in);
+    return reached < w->opponents ? 0 : SHARE_UNIT / (1 + __builtin_popcount(tied));
+}
+
+/* One copy of the showdown per game, so hold'em's carries no Omaha branches */
+static inline int showdown(sim_worker_t *w, cardmask_t board, int to_draw,
+                           const cardmask_t *opp_hole, int n, int drawn)
+{
+    return w->omaha ? showdown_game(w, board, to_draw, opp_hole, n, drawn, true)
+                    : showdown_game(w, board, to_draw, opp_hole, n, drawn, false);
+}
+
+/*
+ * Score the last showdown against the first k opponents for every k at
+ * once: the hero's share of a pot against them while k is within its
+ * run of wins and ties, 0 past its first loss. Opponents are dealt
+ * alike, so the first k stand for any k of them; the action values price
+ * a raise with these (see recommend()). Two differences per trial keep
+ * it off the hot path; a tie, which makes the share step down with k,
+ * costs one per opponent.
+ */
+static inline void tally_prefix(sim_worker_t *w)
+{
+    if (!w->tied) {
+        w->prefix[0] += SHARE_UNIT;
+        w->prefix[w->reached] -= SHARE_UNIT;
+        return;
+    }
+    int prev = 0;
+    for (int k = 1; k <= w->reached; k++) {
+        int share = SHARE_UNIT / (1 + __builtin_popcount(w->tied & ((1u << k) - 1)));
+        w->prefix[k-1] += share - prev;
+        prev = share;
+    }
+    w->prefix[w->reached] -= prev;
+}
+
+/*
+ * A trial that also measures the hero's equity once the next street is
+ * out. The street is drawn and moved to the front of the deck, then each
+ * nested sample deals the ranged opponents again and finishes the deal
+ * from the rest, reusing the trial's deck rather than starting over.
+ * Sample 0 keeps the trial's own ranged holdings and is returned as the
+ * trial's outcome, so the equity itself is sampled just as without a
+ * histogram.
+ */
+static int nested_showdowns(sim_worker_t *w, const cardmask_t *opp_hole, int n, int drawn)
+{
+    cardmask_t street = 0, ranged = 0, hole[MAX_OPPONENTS];
+    for (int i = 0; i < w->street; i++)
+        street |= deck_draw(w->deck, w->pos, n, drawn++, &w->rng);
+    int s = 0;
+    take_cards(w, street, &s);
+    for (int opp = 0; opp < w->opponents; opp++)
+        if (w->range[opp]) ranged |= opp_hole[opp];
+
+    int to_draw = 5 - w->num_community - w->street;
+    int first = 0, score = 0, samples = 0;
+    double won = 0.0;
+    for (int k = 0; k < w->hist_samples; k++) {
+        int d = s, out;
+        if (k == 0) {
+            take_cards(w, ranged, &d);
+            out = first = showdown(w, w->board | street, to_draw, opp_hole, n, d);
+            tally_prefix(w);
+            won = w->won;
+        } else {
+            if (w->ranged && !deal_ranged(w, hole, street, &d)) continue;
+            out = showdown(w, w->board | street, to_draw, w->ranged ? hole : opp_hole, n, d);
+        }
+        score += out;
+        samples++;
+    }
+
+    double eq = score / ((double)SHARE_UNIT * samples);
+    int b = (int)(eq * EQUITY_BUCKETS);
+    w->hist[b < EQUITY_BUCKETS ? b : EQUITY_BUCKETS - 1]++;
+    w->hist_sum += eq;
+    w->hist_sq += eq * eq;
+    w->won = won;
+    return first;
+}
+
+/*
+ * Monte Carlo trials. Ranged opponents are dealt first from their alias
+ * tables and their cards taken out of the deck, then the board and any
+ * random hands come from what is left. A deal in which two ranged
+ * holdings share a card is dropped whole rather than redrawn, which keeps
+ * every draw O(1) and leaves the surviving deals exactly distributed.
+ *
+ * Stratified sampling makes each runout of the board a stratum (every
+ * river card on the turn, every turn and river pair on the flop) and
+ * walks the strata in cycles, each in a fresh random order. A trial
+ * takes its stratum's board and deals the opponents as usual.
+ * Every trial's stratum is uniform, so the plain mean stays unbiased,
+ * and each complete cycle samples every stratum once, so the board's
+ * share of the variance goes away: only the spread within strata is
+ * left (see simulate()).
+ *
+ * Hands are ranked one at a time, and random opponents are dealt only
+ * until one beats the hero. Dealing trials in blocks for a batch (AVX2)
+ * evaluator gives up both, and eval7's L1-resident lookups are no slower
+ * per hand than eight-wide arithmetic or gathers. Most of a trial's time
+ * goes to drawing its cards.
+ */
+static void run_trials(sim_worker_t *w)
+{
+    int cards_to_complete = 5 - w->num_community;   /* board cards needed */
+    cardmask_t opp_hole[MAX_OPPONENTS];
+
+    int n = 0;
+    for (cardmask_t m = w->live; m; m &= m - 1) {
+        w->pos[__builtin_ctzll(m)] = (uint8_t)n;
+        w->deck[n++] = (uint8_t)__builtin_ctzll(m);
+    }
+
+    for (int sim = 0; sim < w->trials; sim++) {
+        int drawn = 0;
+
+        if (w->ranged && !deal_ranged(w, opp_hole, 0, &drawn)) {
+            w->dropped++;
+            continue;
+        }
+
+        int out;
+        if (w->num_strata) {
+            if (w->cycle_pos == w->num_strata) {
+                for (int i = w->num_strata - 1; i > 0; i--) {
+                    int j = (int)rng_bounded(&w->rng, (uint32_t)(i + 1));
+                    uint16_t t = w->order[i]; w->order[i] = w->order[j]; w->order[j] = t;
+                }
+                w->cycle_pos = 0;
+            }
+            int h = w->order[w->cycle_pos++];
+            cardmask_t fixed = w->strata[h];
+            take_cards(w, fixed, &drawn);
+            out = showdown(w, w->board | fixed, 0, opp_hole, n, drawn);
+            tally_prefix(w);
+            w->tally[h].n++;
+            w->tally[h].sum += out;
+            w->tally[h].sq += (long)out * out;
+        } else if (w->hist_samples) {
+            out = nested_showdowns(w, opp_hole, n, drawn);
+        } else {
+            out = showdown(w, w->board, cards_to_complete, opp_hole, n, drawn);
+            tally_prefix(w);
+        }
+        w->score += out;
+        w->score_sq += (long)out * out;
+        w->chips += w->won;
+        w->outcomes++;
+    }
+}
+
+static double choose(int n, int k)
+{
+    double c = 1.0;
+    if (k < 0 || k > n) return 0.0;
+    for (int i = 0; i < k; i++) c = c * (n - i) / (i + 1);
+    return c;
+}
+
+/* Exact enumeration state for one complete board */
+typedef struct {
+    hand_val_t  hero;
+    int         num_holdings;
+    hand_val_t *val;    /* every 2-card (Omaha: 4-card) holding */
+    cardmask_t *mask;   /* and its cards */
+} exact_board_t;
+
+/*
+ * Deal the remaining opponents every unordered set of disjoint holdings,
+ * counting how many of them the hero beats and ties
+ */
+static void exact_deal(sim_worker_t *w, const exact_board_t *eb, int start,
+                       int left, cardmask_t used, int beaten, int tied)
+{
+    for (int p = start; p < eb->num_holdings; p++) {
+        if (eb->mask[p] & used) continue;
+        int b = beaten + (eb->val[p] < eb->hero);
+        int t = tied + (eb->val[p] == eb->hero);
+        if (left > 1) {
+            exact_deal(w, eb, p+1, left-1, used | eb->mask[p], b, t);
+            continue;
+        }
+        if (b + t == w->opponents) w->score += SHARE_UNIT / (1 + t);
+        w->deals[b][t]++;
+        w->outcomes++;
+    }
+}
+
+static void exact_board(sim_worker_t *w, exact_board_t *eb, cardmask_t board, cardmask_t rest)
+{
+    eb->num_holdings = 0;
+    if (w->omaha) {
+        omaha_board_t ob;
+        omaha_prepare(&ob, board);
+        eb->hero = omaha_finish(&ob, w->hole);
+        for (cardmask_t a = rest; a; a &= a - 1)
+            for (cardmask_t b = a & (a - 1); b; b &= b - 1)
+                for (cardmask_t c = b & (b - 1); c; c &= c - 1)
+                    for (cardmask_t d = c & (c - 1); d; d &= d - 1) {
+                        cardmask_t hole = (a & -a) | (b & -b) | (c & -c) | (d & -d);
+                        eb->val[eb->num_holdings] = omaha_finish(&ob, hole);
+                        eb->mask[eb->num_holdings++] = hole;
+                    }
+    } else {
+        board_eval_t be;
+        board_prepare(&be, board);
+        eb->hero = board_finish(&be, w->hole);
+        for (cardmask_t a = rest; a; a &= a - 1) {
+            cardmask_t abit = a & -a;
+            for (cardmask_t b = a & (a - 1); b; b &= b - 1) {
+                cardmask_t pair = abit | (b & -b);
+                eb->val[eb->num_holdings] = board_finish(&be, pair);
+                eb->mask[eb->num_holdings++] = pair;
+            }
+        }
+    }
+    w->evals += 1 + eb->num_holdings;
+    exact_deal(w, eb, 0, w->opponents, 0, 0, 0);
+}
+
+/* Walk every board completion, keeping those assigned to this worker */
+static void run_exact(sim_worker_t *w)
+{
+    int k = 5 - w->num_community;
+    int n = 0, idx[5];
+    int live[DECK_SIZE];
+    long seq = 0;
+    exact_board_t eb_store, *eb = &eb_store;
+    size_t holdings = (size_t)choose(w->num_live - k, w->omaha ? 4 : 2);
+    eb->val = malloc(sizeof(hand_val_t) * holdings);
+    eb->mask = malloc(sizeof(cardmask_t) * holdings);
+
+    for (cardmask_t m = w->live; m; m &= m - 1) live[n++] = __builtin_ctzll(m);
+    for (int i = 0; i < k; i++) idx[i] = i;
+    for (;;) {
+        if (seq++ % w->nthreads == w->index) {
+            cardmask_t drawn = 0;
+            for (int i = 0; i < k; i++) drawn |= 1ULL << live[idx[i]];
+            exact_board(w, eb, w->board | drawn, w->live & ~drawn);
+        }
+
+        /* Next k-combination of the live cards in lexicographic order */
+        int p = k - 1;
+        while (p >= 0 && idx[p] == n - k + p) p--;
+        if (p < 0) break;
+        idx[p]++;
+        for (int i = p+1; i < k; i++) idx[i] = idx[i-1] + 1;
+    }
+    free(eb->val);
+    free(eb->mask);
+}
+
+/* Number of distinct showdowns: board completions x opponent deals */
+static double exact_outcome_count(int num_live, int num_community, int opponents, int hole_cards)
+{
+    int k = 5 - num_community;
+    int rest = num_live - k;
+    double n = choose(num_live, k);
+    for (int i = 0; i < opponents; i++)
+        n *= choose(rest - hole_cards*i, hole_cards) / (i + 1);
+    return n;
+}
+
+static void *run_worker_thread(void *arg)
+{
+    sim_worker_t *w = arg;
+    w->run(w);
+    return NULL;
+}
+
+/* Run every worker's current share to completion; worker 0 on this thread */
+static void run_workers(sim_worker_t *workers, int nthreads)
+{
+    pthread_t tids[MAX_THREADS];
+    int started = 1;
+
+    for (int t = 1; t < nthreads; t++, started++)
+        if (pthread_create(&tids[t], NULL, run_worker_thread, &workers[t]) != 0)
+            break;
+    workers[0].run(&workers[0]);
+    for (int t = started; t < nthreads; t++)   /* thread creation failed: run inline */
+        workers[t].run(&workers[t]);
+    for (int t = 1; t < started; t++)
+        pthread_join(tids[t], NULL);
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/*
+ * Simulation:
+ * Given player's hole cards and current community cards,
+ * estimate the chance of beating opts->opponents random hands.
+ * Returns the hero's expected share of the pot (0.0 to 1.0): all of it
+ * for a win, split evenly among everyone who ties for best.
+ * Also fills out best_rank with current best hand info, and res (if not
+ * NULL) with the method used, its cost and its precision.
+ *
+ * When the number of distinct showdowns is within opts->exact_budget every
+ * one is enumerated and the equity is exact. Otherwise Monte Carlo trials
+ * run in rounds of SIM_BATCH per worker until the standard error of the
+ * equity reaches opts->target_se, opts->trials samples have been drawn, or
+ * opts->max_ms has passed. Each worker has its own RNG stream derived from
+ * opts->seed and counts are summed in worker order, so a given (seed,
+ * threads) pair always returns the same equity unless the time cap fires.
+ * Opponents with a range in opts->ranges are always sampled, and sampling
+ * gives up once more than SIM_MAX_DROPPED deals per capped sample have
+ * been dropped (see run_trials()).
+ *
+ * With opts->stratified, flop and turn spots without ranges or a
+ * histogram are sampled by runout stratum. (Preflop, two of the five
+ * board cards explain too little of the variance to pay for the
+ * strata.) Their standard error then comes from the pooled variance
+ * within strata, and the ratio of the plain variance to it is reported
+ * as the variance reduction: the factor by which plain sampling would
+ * need more trials for the same standard error.
+ *
+ * With opts->stacks, every player is all in for that many more chips on
+ * top of opts->pot, and res->chips is what the hero expects to take back
+ * from the main and side pots, split exactly on ties. The equity is
+ * still the share of one pot all of them contest.
+ */
+static double simulate(cardmask_t hole, cardmask_t community,
+                       rank_t *best_rank, const sim_opts_t *opts, sim_result_t *res)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int num_community = mask_count(community);
+    cardmask_t live = FULL_DECK & ~(hole | community);
+    int num_live = mask_count(live);
+
+    /* Current best hand if enough cards */
+    if (num_community >= 3) {
+        *best_rank = opts->omaha ? omaha_best_hand(hole, community) : best_hand(hole | community);
+    } else {
+        best_rank->rankVal = 9;
+        best_rank->high = -1;
+        for (cardmask_t m = hole; m; m &= m - 1)
+            if (bit_card(__builtin_ctzll(m)).face > best_rank->high) best_rank->high = bit_card(__builtin_ctzll(m)).face;
+        best_rank->high2 = -1;
+        best_rank->kicker = -1;
+    }
+
+    /* One alias table per distinct opponent range, minus the known cards */
+    alias_t *tables = NULL;
+    const alias_t *range[MAX_OPPONENTS] = {NULL};
+    bool ranged = false, possible = true;
+    if (opts->num_ranges > 0) {
+        tables = malloc(sizeof(alias_t) * MAX_OPPONENTS);
+        for (int i = 0; i < opts->opponents; i++) {
+            if (i >= opts->num_ranges) {   /* the last range repeats */
+                range[i] = range[i-1];
+                continue;
+            }
+            possible &= alias_build(&tables[i], &opts->ranges[i], hole | community);
+            range[i] = &tables[i];
+        }
+        ranged = true;
+    }
+
+    /* The next street's histogram needs a board still to come */
+    int street = (num_community == 0) ? 3 : (num_community < 5) ? 1 : 0;
+    int hist_samples = street ? opts->hist_samples : 0;
+
+    /*
+     * Side pots. Enumeration deals the opponents unordered sets of
+     * holdings, which prices pots only when every opponent is in the same
+     * ones: one opponent, or equal stacks.
+     */
+    pots_t pots;
+    bool symmetric = true;
+    if (opts->stacks) {
+        pots_build(&pots, opts->stacks, opts->opponents, opts->pot);
+        for (int i = 1; i < opts->opponents; i++) symmetric &= opts->stacks[i+1] == opts->stacks[1];
+    }
+
+    /* Enumeration weighs every holding alike, so ranged spots are sampled */
+    bool exact = !ranged && !hist_samples && symmetric &&
+                 exact_outcome_count(num_live, num_community, opts->opponents, opts->omaha ? 4 : 2) <= opts->exact_budget;
+
+    int nthreads = opts->threads;
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > MAX_THREADS) nthreads = MAX_THREADS;
+
+    /* Strata: every runout of the board */
+    int strata_cards = 0, num_strata = 0;
+    cardmask_t *strata = NULL;
+    stratum_t *tally = NULL;
+    uint16_t *order = NULL;
+    if (opts->stratified && !exact && !ranged && !hist_samples && (num_community == 3 || num_community == 4)) {
+        strata_cards = 5 - num_community;
+        strata = malloc(sizeof(cardmask_t) * (size_t)choose(num_live, strata_cards));
+        for (cardmask_t a = live; a; a &= a - 1)
+            for (cardmask_t b = (strata_cards == 1) ? 1 : a & (a - 1); b; b &= b - 1)
+                strata[num_strata++] = (a & -a) | (strata_cards == 1 ? 0 : b & -b);
+        tally = calloc((size_t)nthreads * num_strata, sizeof(stratum_t));
+        order = malloc(sizeof(uint16_t) * (size_t)nthreads * num_strata);
+    }
+
+    /* A single worker lives on the stack: no allocation per query */
+    sim_worker_t one;
+    sim_worker_t *workers = &one;
+    if (nthreads > 1) workers = calloc((size_t)nthreads, sizeof(sim_worker_t));
+    else memset(&one, 0, sizeof(one));
+    rng_t stream;   /* worker k draws from the seed's stream jumped k times */
+    rng_seed(&stream, opts->seed);
+
+    for (int t = 0; t < nthreads; t++) {
+        sim_worker_t *w = &workers[t];
+        w->run = exact ? run_exact : run_trials;
+        w->hole = hole;
+        w->board = community;
+        w->num_community = num_community;
+        w->live = live;
+        w->num_live = num_live;
+        w->opponents = opts->opponents;
+        w->omaha = opts->omaha;
+        memcpy(w->range, range, sizeof(range));
+        w->ranged = ranged;
+        w->hist_samples = hist_samples;
+        w->street = street;
+        w->index = t;
+        w->nthreads = nthreads;
+        w->rng = stream;
+        if (t + 1 < nthreads) rng_jump(&stream);
+        if (opts->stacks && !exact) w->pots = &pots;
+        if (num_strata) {
+            w->strata = strata;
+            w->num_strata = num_strata;
+            w->tally = tally + (size_t)t * num_strata;
+            w->order = order + (size_t)t * num_strata;
+            for (int h = 0; h < num_strata; h++) w->order[h] = (uint16_t)h;
+            w->cycle_pos = num_strata;
+        }
+    }
+
+    long score = 0, score_sq = 0, total = 0, evals = 0, dropped = 0;
+    double se = 0.0, reduction = 1.0, chips = 0.0;
+    pa_stop_t stop = PA_STOP_DONE;
+
+    for (; possible;) {
+        if (!exact) {
+            /* Next round: up to SIM_BATCH deals per worker, within the cap */
+            long round = (long)SIM_BATCH * nthreads;
+            if (round > opts->trials - total) round = opts->trials - total;
+            for (int t = 0; t < nthreads; t++)
+                workers[t].trials = (int)(round / nthreads + (t < round % nthreads ? 1 : 0));
+        }
+        run_workers(workers, nthreads);
+
+        score = score_sq = total = evals = dropped = 0;
+        chips = 0.0;
+        for (int t = 0; t < nthreads; t++) {
+            score += workers[t].score;
+            score_sq += workers[t].score_sq;
+            chips += workers[t].chips;
+            total += workers[t].outcomes;
+            evals += workers[t].evals;
+            dropped += workers[t].dropped;
+        }
+        if (exact) break;
+        if (dropped > (long)SIM_MAX_DROPPED * opts->trials) { stop = PA_STOP_SAMPLES; break; }
+        if (total == 0) continue;
+
+        /* Each trial scores its pot share; standard error of their mean */
+        double mean = (double)score / SHARE_UNIT / total;
+        double mean_sq = (double)score_sq / ((double)SHARE_UNIT * SHARE_UNIT) / total;
+        double var = mean_sq - mean * mean;
+        if (var < 0.0) var = 0.0;
+        se = sqrt(var / total);
+        if (num_strata) {
+            /*
+             * Complete cycles leave only the pooled variance within strata;
+             * a worker's unfinished cycle of r trials adds the spread
+             * between strata over a random r of the S.
+             */
+            double within = 0.0, partial = 0.0;
+            long df = 0;
+            for (int h = 0; h < num_strata; h++) {
+                long n = 0, sum = 0, sq = 0;
+                for (int t = 0; t < nthreads; t++) {
+                    n += workers[t].tally[h].n;
+                    sum += workers[t].tally[h].sum;
+                    sq += workers[t].tally[h].sq;
+                }
+                if (n < 2) continue;
+                within += (sq - (double)sum * sum / n) / ((double)SHARE_UNIT * SHARE_UNIT);
+                df += n - 1;
+            }
+            for (int t = 0; t < nthreads; t++) {
+                int r = workers[t].cycle_pos % num_strata;
+                partial += (double)r * (num_strata - r) / (num_strata - 1 > 0 ? num_strata - 1 : 1);
+            }
+            if (df > 0) {
+                within /= df;
+                double between = var > within ? var - within : 0.0;
+                double var_mean = within / total + partial * between / ((double)total * total);
+                if (var_mean > 0.0) {
+                    reduction = var / total / var_mean;
+                    se = sqrt(var_mean);
+                }
+            }
+        }
+
+        if (opts->target_se > 0.0 && total >= SIM_MIN_SAMPLES && se <= opts->target_se) {
+            stop = PA_STOP_TARGET; break;
+        }
+        if (total >= opts->trials) { stop = PA_STOP_SAMPLES; break; }
+        if (opts->max_ms > 0.0 && elapsed_ms(&start) >= opts->max_ms) {
+            stop = PA_STOP_TIME; break;
+        }
+    }
+    if (res) {
+        res->method = exact ? PA_EXACT : PA_MONTE_CARLO;
+        res->stop = stop;
+        res->outcomes = total;
+        res->evaluations = evals;
+        res->dropped = dropped;
+        res->std_error = se;
+        res->sampling = num_strata ? PA_SAMPLE_STRATIFIED : PA_SAMPLE_PLAIN;
+        res->variance_reduction = reduction;
+
+        /* Every kept trial adds one equity to the histogram */
+        double sum = 0.0, sq = 0.0;
+        memset(res->hist, 0, sizeof(res->hist));
+        res->hist_trials = hist_samples ? total : 0;
+        for (int t = 0; t < nthreads && hist_samples; t++) {
+            for (int b = 0; b < EQUITY_BUCKETS; b++) res->hist[b] += workers[t].hist[b];
+            sum += workers[t].hist_sum;
+            sq += workers[t].hist_sq;
+        }
+        res->hist_mean = res->hist_trials ? sum / res->hist_trials : 0.0;
+        double var = res->hist_trials ? sq / res->hist_trials - res->hist_mean * res->hist_mean : 0.0;
+        res->hist_sd = sqrt(var > 0.0 ? var : 0.0);
+
+        /*
+         * Equity against k of the opponents. Sampled: the trials' shares
+         * against the first k. Exact: of a deal's C(n,k) k-subsets, where
+         * it beats b and ties t of the n, C(t,j) C(b,k-j) tie j and beat
+         * the rest, for a 1/(j+1) share each.
+         */
+        int opps = opts->opponents;
+        double shares[MAX_OPPONENTS + 1] = {0};
+        for (int t = 0; t < nthreads; t++) {
+            long run = 0;
+            for (int k = 1; k <= opps; k++) {
+                run += workers[t].prefix[k-1];
+                shares[k] += (double)run / SHARE_UNIT;
+                for (int b = 0; exact && b <= opps; b++)
+                    for (int tie = 0; b + tie <= opps; tie++) {
+                        if (!workers[t].deals[b][tie]) continue;
+                        double subsets = 0.0;
+                        for (int j = 0; j <= tie && j <= k; j++)
+                            subsets += choose(tie, j) * choose(b, k - j) / (j + 1);
+                        shares[k] += workers[t].deals[b][tie] * subsets / choose(opps, k);
+                    }
+            }
+        }
+        res->eq_vs[0] = 1.0;
+        for (int k = 1; k <= MAX_OPPONENTS; k++)
+            res->eq_vs[k] = (k <= opps && total) ? shares[k] / total : 0.0;
+
+        /*
+         * Chips from the side pots. Exact spots have every opponent in the
+         * same pots 1..in: a deal the hero loses leaves it the pots above,
+         * one beating b and tying t of them a 1/(t+1) share of those too.
+         */
+        res->chips = 0.0;
+        if (opts->stacks && exact && total) {
+            int in = pots.in[0], none[MAX_OPPONENTS + 2] = {0};
+            for (int t = 0; t < nthreads; t++)
+                for (int b = 0; b <= opps; b++)
+                    for (int tie = 0; b + tie <= opps; tie++) {
+                        int tied_in[MAX_OPPONENTS + 2] = {0};
+                        tied_in[in] = tie;
+                        chips += workers[t].deals[b][tie] *
+                            (b + tie == opps ? pots_won(&pots, 0, tied_in) : pots_won(&pots, in, none));
+                    }
+        }
+        if (opts->stacks && total) res->chips = chips / total;
+    }
+    if (workers != &one) free(workers);
+    free(tables);
+    free(strata);
+    free(tally);
+    free(order);
+
+    if (total == 0) return 0.0;
+    return (double)score / SHARE_UNIT / total;
+}
+
+/*
+ * Precomputed preflop equity.
+ *
+ * The 169 canonical starting hands sit on a 13x13 grid: pairs on the
+ * diagonal, suited hands at [high][low] and offsuit at [low][high]. The
+ * table file (written by preflop_table_gen) is a header followed by one
+ * entry per hand and opponent count 1..MAX_OPPONENTS, memory-mapped so a
+ * preflop query costs a single lookup.
+ */
+#define PREFLOP_CLASSES   169
+#define PREFLOP_MAGIC     "PFEQ"
+#define PREFLOP_VERSION   2      /* 2: ties split evenly among the winners */
+#define PREFLOP_FILE      "preflop_equity.bin"
+
+typedef struct {
+    char     magic[4];
+    uint32_t version;
+    uint32_t num_classes;
+    uint32_t max_opponents;
+} preflop_header_t;
+
+typedef struct {
+    float    equity;      /* pot share, ties split evenly */
+    float    std_error;   /* standard error of equity */
+    uint32_t samples;     /* Monte Carlo trials behind this entry */
+} preflop_entry_t;
+
+typedef struct {
+    const void            *map;
+    size_t                 size;
+    const preflop_entry_t *entries;   /* [class][opponents-1] */
+} preflop_table_t;
+
+static int preflop_class(card_t a, card_t b)
+{
+    int hi = a.face > b.face ? a.face : b.face;
+    int lo = a.face > b.face ? b.face : a.face;
+    if (hi == lo || a.suit == b.suit) return hi * 13 + lo;
+    return lo * 13 + hi;
+}
+
+/* Name of a canonical hand, e.g. "AKs", "T9o", "77" */
+static void preflop_class_name(int cls, char name[4])
+{
+    int row = cls / 13, col = cls % 13;
+    int hi = row > col ? row : col, lo = row > col ? col : row;
+    name[0] = face_str(hi)[0];
+    name[1] = face_str(lo)[0];
+    name[2] = (hi == lo) ? '\0' : (row > col ? 's' : 'o');
+    name[3] = '\0';
+}
+
+/* Map a table file; returns false (and leaves tbl empty) if missing or invalid */
+static bool preflop_table_open(preflop_table_t *tbl, const char *path)
+{
+    memset(tbl, 0, sizeof(*tbl));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    size_t want = sizeof(preflop_header_t) +
+                  sizeof(preflop_entry_t) * PREFLOP_CLASSES * MAX_OPPONENTS;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != want) { close(fd); return false; }
+
+    void *map = mmap(NULL, want, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const preflop_header_t *h = map;
+    if (memcmp(h->magic, PREFLOP_MAGIC, 4) != 0 || h->version != PREFLOP_VERSION ||
+        h->num_classes != PREFLOP_CLASSES || h->max_opponents != MAX_OPPONENTS) {
+        munmap(map, want);
+        return false;
+    }
+    tbl->map = map;
+    tbl->size = want;
+    tbl->entries = (const preflop_entry_t *)(h + 1);
+    return true;
+}
+
+static void preflop_table_close(preflop_table_t *tbl)
+{
+    if (tbl->map) munmap((void *)tbl->map, tbl->size);
+    memset(tbl, 0, sizeof(*tbl));
+}
+
+static const preflop_entry_t *preflop_lookup(const preflop_table_t *tbl,
+                                             const card_t hole[2], int opponents)
+{
+    if (!tbl->entries || opponents < 1 || opponents > MAX_OPPONENTS) return NULL;
+    const preflop_entry_t *e =
+        &tbl->entries[preflop_class(hole[0], hole[1]) * MAX_OPPONENTS + opponents - 1];
+    return e->samples ? e : NULL;
+}
+
+/* Category of a hand value, higher is better */
+#define VAL_CATEGORY(v)  ((v) >> 12)
+
+/*
+ * Category of a 4 or 5 card board by itself, from bit-sliced face counts
+ * rather than counts_value(), which would cost more than the rest of
+ * count_outs() put together.
+ */
+static int board_category(cardmask_t board)
+{
+    unsigned s0 = SUIT_FACES(board, 0), s1 = SUIT_FACES(board, 1);
+    unsigned s2 = SUIT_FACES(board, 2), s3 = SUIT_FACES(board, 3);
+    hand_val_t f = flush_val[s0] | flush_val[s1] | flush_val[s2] | flush_val[s3];
+    unsigned x01 = s0 ^ s1, x23 = s2 ^ s3;
+    unsigned ones = x01 ^ x23;                                /* held 1 or 3 times */
+    unsigned twos = (s0 & s1) ^ (s2 & s3) ^ (x01 & x23);      /* held 2 or 3 times */
+    unsigned trips = ones & twos, pairs = twos & ~ones;
+    unsigned faces = s0 | s1 | s2 | s3;
+    unsigned low = (faces << 1) | (faces >> 12);   /* faces up one, the ace below the deuce too */
+    unsigned run = low & (low << 1);
+    run &= run << 2;
+    run &= low << 4;                               /* five faces in a row */
+    int rank_val = 9;
+
+    if (f) return VAL_CATEGORY(f);
+    if (s0 & s1 & s2 & s3)        rank_val = 2;
+    else if (trips && pairs)      rank_val = 3;
+    else if (run)                 rank_val = 5;
+    else if (trips)               rank_val = 6;
+    else if (pairs & (pairs - 1)) rank_val = 7;
+    else if (pairs)               rank_val = 8;
+    return 9 - rank_val;
+}
+
+/*
+ * Whether a hand that was category now on a board of category was_board
+ * improved through its hole cards once the board is next: it must climb
+ * more categories than the board did by itself. Pairing the board moves
+ * both up one, so 88 on Kh7s2d does not improve with a king, while A7
+ * does with a seven (one pair to trips).
+ */
+static inline bool improves(int cat, int now, int was_board, cardmask_t next)
+{
+    return cat - now > board_category(next) - was_board;
+}
+
+/* Category of an Omaha hand on a board of 3 to 5 cards */
+static int omaha_category(cardmask_t hole, cardmask_t board)
+{
+    omaha_board_t ob;
+    omaha_prepare(&ob, board);
+    return VAL_CATEGORY(omaha_finish(&ob, hole));
+}
+
+/*
+ * Outs. Every unseen card is dealt as the next card and the hand ranked
+ * again; a card is an out when it improves the hero's hand through a
+ * hole card (see improves()), so a card that only pairs the board is not
+ * an out. Improvement by the river applies the same test to every
+ * remaining runout. A flop costs 47 + 1081 evaluations, some 15
+ * microseconds. An Omaha hand must use two hole cards, so the board can
+ * never play by itself and an out need only lift the hand's own category.
+ */
+static void count_outs(cardmask_t hole, cardmask_t board, bool omaha, outs_t *o)
+{
+    int num_board = mask_count(board);
+    memset(o, 0, sizeof(*o));
+    if (num_board < 3 || num_board > 4) return;
+
+    int now = omaha ? omaha_category(hole, board) : VAL_CATEGORY(eval_mask(hole | board));
+    int was_board = board_category(board);
+    cardmask_t live = FULL_DECK & ~(hole | board);
+    long runouts = 0, better = 0;
+
+    o->unseen = mask_count(live);
+    for (cardmask_t a = live; a; a &= a - 1) {
+        cardmask_t next = board | (a & -a);
+        int cat = omaha ? omaha_category(hole, next) : VAL_CATEGORY(eval_mask(hole | next));
+        if (omaha ? cat > now : improves(cat, now, was_board, next)) {
+            o->outs++;
+            o->by_rank[9 - cat]++;
+        }
+        if (num_board == 4) continue;
+        for (cardmask_t b = a & (a - 1); b; b &= b - 1) {
+            cardmask_t river = next | (b & -b);
+            better += omaha ? omaha_category(hole, river) > now
+                            : improves(VAL_CATEGORY(eval7(hole | river)), now, was_board, river);
+            runouts++;
+        }
+    }
+    o->improve_next = (double)o->outs / o->unseen;
+    o->improve_river = (num_board == 4) ? o->improve_next : (double)better / runouts;
+}
+
+/*
+ * Recommend an action by expected value. Each action is priced in chips
+ * won from here on, folding being 0:
+ *
+ *   check/call  eq * (pot + to_call) - to_call
+ *   raise r     every opponent folds: pot
+ *               K of them call:       eq_K * (pot + to_call + r + K*r) - (to_call + r)
+ *
+ * with a raise of r over the call tried at each of RAISE_SIZES of the
+ * pot. Fold equity is the minimum defence frequency: facing r into a pot
+ * of P, each opponent folds r / (P + r) of the time, the most it can
+ * without a pure bluff profiting, so the number of callers K is binomial.
+ * The folds come out of the hands the hero beats, so a caller is stronger
+ * than a random hand: against each one the hero's chance q of winning
+ * heads-up falls to (q - f) / (1 - f), and eq_K is scaled by that ratio
+ * once per caller. eq_K, the equity against K opponents, comes from the
+ * same trials as the headline equity (sim_result_t.eq_vs), so every size
+ * is priced on common random numbers at no extra cost.
+ *
+ * No raise goes past max_raise, what the effective stack leaves over the
+ * call, and a capped raise may be smaller than a min-raise (it is all
+ * in). With nothing left over every raise is 0, a raise of 0 is worth
+ * exactly the call, and the advice is to call or fold.
+ */
+#define NUM_RAISE_SIZES PA_NUM_RAISE_SIZES
+static const double RAISE_SIZES[NUM_RAISE_SIZES] = {0.5, 0.75, 1.0, 1.5, 2.0};
+
+static double raise_ev(const double *eq_vs, int opponents, int pot, int to_call, int r)
+{
+    double f = (double)r / (pot + to_call + r);
+    double q = eq_vs[1];
+    double shrink = (q > f) ? (q - f) / (q * (1.0 - f)) : 0.0;
+    double ev = pow(f, opponents) * pot, scale = 1.0;
+
+    for (int k = 1; k <= opponents; k++) {
+        scale *= shrink;
+        double p = choose(opponents, k) * pow(1.0 - f, k) * pow(f, opponents - k);
+        double won = eq_vs[k] * scale * (pot + to_call + r + (double)k * r);
+        ev += p * (won - (to_call + r));
+    }
+    return ev;
+}
+
+static advice_t recommend(const double *eq_vs, int opponents, int pot, int to_call, int big_blind,
+                          int max_raise)
+{
+    advice_t a;
+    double win_pct = eq_vs[opponents];
+    a.win_pct = win_pct;
+    a.amount = 0;
+
+    /* Strength label */
+    if (win_pct >= 0.70)      a.strength = "Very Strong";
+    else if (win_pct >= 0.50) a.strength = "Strong";
+    else if (win_pct >= 0.35) a.strength = "Medium";
+    else if (win_pct >= 0.20) a.strength = "Weak";
+    else                      a.strength = "Very Weak";
+
+    /* Passive first: a raise has to be worth strictly more */
+    a.ev_call = win_pct * (pot + to_call) - to_call;
+    if (to_call > 0 && a.ev_call < 0.0) {
+        a.action = "FOLD";
+        a.ev = 0.0;
+    } else {
+        a.action = (to_call > 0) ? "CALL" : "CHECK";
+        a.amount = to_call;
+        a.ev = a.ev_call;
+    }
+
+    /* At least a min-raise: the bet faced, and never under the big blind */
+    int min_raise = (to_call > big_blind) ? to_call : big_blind;
+    for (int i = 0; i < NUM_RAISE_SIZES; i++) {
+        int r = (int)(RAISE_SIZES[i] * (pot + to_call) + 0.5);
+        if (r < min_raise) r = min_raise;
+        if (r > max_raise) r = max_raise > 0 ? max_raise : 0;
+        a.raise[i] = r;
+        a.ev_raise[i] = raise_ev(eq_vs, opponents, pot, to_call, r);
+        if (a.ev_raise[i] > a.ev) {
+            a.action = "RAISE";
+            a.amount = r;
+            a.ev = a.ev_raise[i];
+        }
+    }
+    return a;
+}
+
+/* Every card valid and none twice */
+static bool check_cards(const request_t *req, char *err, size_t errlen)
+{
+    card_t all_cards[9];
+    cardmask_t seen = 0;
+    int n = 0;
+
+    if (req->num_community < 0 || req->num_community > 5) {
+        snprintf(err, errlen, "at most 5 community cards.");
+        return false;
+    }
+    if (req->game != PA_GAME_HOLDEM && req->game != PA_GAME_OMAHA) {
+        snprintf(err, errlen, "game must be holdem or omaha.");
+        return false;
+    }
+    for (int c = 0; c < HOLE_CARDS(req); c++) all_cards[n++] = req->hole[c];
+    for (int c = 0; c < req->num_community; c++) all_cards[n++] = req->community[c];
+    for (int c = 0; c < n; c++) {
+        if (all_cards[c].face < 0 || all_cards[c].face > 12 ||
+            all_cards[c].suit < 0 || all_cards[c].suit > 3) {
+            snprintf(err, errlen, "invalid card.");
+            return false;
+        }
+        if (seen & card_bit(all_cards[c])) {
+            snprintf(err, errlen, "duplicate card %s%c detected.",
+                face_str(all_cards[c].face), suit_char(all_cards[c].suit));
+            return false;
+        }
+        seen |= card_bit(all_cards[c]);
+    }
+    return true;
+}
+
+/* A whole decimal number in lo..hi, or false */
+static bool parse_int(const char *s, long lo, long hi, int *out)
+{
+    char *end;
+    long v = strtol(s, &end, 10);
+    if (end == s || *end || v < lo || v > hi) return false;
+    *out = (int)v;
+    return true;
+}
+
+/*
+ * Parse "<hole1> <hole2> [community1..5] [pot] [to_call] [key=value ...]"
+ * where key is opponents, samples, seed, range, histogram, sampling
+ * (plain or stratified), stacks (hero's then each opponent's, comma
+ * separated) or game (holdem or omaha; Omaha spots give four hole
+ * cards). Returns false with a message in err on bad input.
+ */
+static bool parse_request(char **tok, int ntok, request_t *req, char *err, size_t errlen)
+{
+    memset(req, 0, sizeof(*req));
+
+    /* The game says how many of the cards are hole cards */
+    for (int t = 0; t < ntok; t++) {
+        if (strncmp(tok[t], "game=", 5) != 0) continue;
+        if (strcmp(tok[t] + 5, "omaha") == 0) req->game = PA_GAME_OMAHA;
+        else if (strcmp(tok[t] + 5, "holdem") == 0) req->game = PA_GAME_HOLDEM;
+        else {
+            snprintf(err, errlen, "game must be holdem or omaha.");
+            return false;
+        }
+    }
+    int i = 0;
+    for (; i < HOLE_CARDS(req); i++)
+        if (i >= ntok || !parse_card(tok[i], &req->hole[i])) {
+            snprintf(err, errlen, "invalid hole card format.");
+            return false;
+        }
+
+    /* Community cards first, then numeric pot/to_call, then key=value */
+    int numeric = 0;
+    while (i < ntok && req->num_community < 5 && parse_card(tok[i], &req->community[req->num_community])) {
+        req->num_community++;
+        i++;
+    }
+    if (req->num_community == 1 || req->num_community == 2) {
+        snprintf(err, errlen, "community cards must be 0 (pre-flop), 3 (flop), 4 (turn), or 5 (river).");
+        return false;
+    }
+    for (; i < ntok; i++) {
+        const char *eq = strchr(tok[i], '=');
+        if (!eq) {
+            if (numeric < 2 && !parse_int(tok[i], 0, MAX_CHIPS, numeric ? &req->to_call : &req->pot)) {
+                snprintf(err, errlen, "%s must be a whole number of chips, 0 to %d.",
+                    numeric ? "to_call" : "pot", MAX_CHIPS);
+                return false;
+            }
+            numeric++;
+        } else if (strncmp(tok[i], "opponents=", 10) == 0) {
+            if (!parse_int(eq + 1, 1, MAX_OPPONENTS, &req->opponents)) {
+                snprintf(err, errlen, "opponents must be between 1 and %d.", MAX_OPPONENTS);
+                return false;
+            }
+        } else if (strncmp(tok[i], "samples=", 8) == 0) {
+            if (!parse_int(eq + 1, 1, INT_MAX, &req->samples)) {
+                snprintf(err, errlen, "samples must be at least 1.");
+                return false;
+            }
+        } else if (strncmp(tok[i], "seed=", 5) == 0) {
+            req->seed = strtoull(eq + 1, NULL, 0);
+        } else if (strncmp(tok[i], "range=", 6) == 0) {
+            range_t *check = malloc(sizeof(range_t) * MAX_OPPONENTS);
+            int ok = range_parse(check, eq + 1, err, errlen);
+            free(check);
+            if (!ok) return false;
+            req->range = eq + 1;
+        } else if (strncmp(tok[i], "sampling=", 9) == 0) {
+            if (strcmp(eq + 1, "plain") == 0) req->sampling = PA_SAMPLE_PLAIN;
+            else if (strcmp(eq + 1, "stratified") == 0) req->sampling = PA_SAMPLE_STRATIFIED;
+            else {
+                snprintf(err, errlen, "sampling must be plain or stratified.");
+                return false;
+            }
+        } else if (strncmp(tok[i], "stacks=", 7) == 0) {
+            char *end = (char *)eq;
+            req->num_stacks = 0;
+            do {
+                long c = strtol(end + 1, &end, 10);
+                if (req->num_stacks == MAX_OPPONENTS + 1 || c < 1 || c > INT_MAX) {
+                    snprintf(err, errlen, "stacks must be 2 to %d positive chip counts.", MAX_OPPONENTS + 1);
+                    return false;
+                }
+                req->stacks[req->num_stacks++] = (int)c;
+            } while (*end == ',');
+            if (*end || req->num_stacks < 2) {
+                snprintf(err, errlen, "stacks must be 2 to %d positive chip counts.", MAX_OPPONENTS + 1);
+                return false;
+            }
+        } else if (strncmp(tok[i], "game=", 5) == 0) {
+            continue;   /* read above */
+        } else if (strncmp(tok[i], "histogram=", 10) == 0) {
+            if (!parse_int(eq + 1, 1, INT_MAX, &req->histogram)) {
+                snprintf(err, errlen, "histogram must be at least 1.");
+                return false;
+            }
+        } else {
+            snprintf(err, errlen, "unknown field %s.", tok[i]);
+            return false;
+        }
+    }
+
+    return check_cards(req, err, errlen);
+}
+
+/* Spot lines: a request line, CSV or a flat JSON object */
+static pa_line_format_t spot_format(const char *line)
+{
+    if (*line == '{') return PA_LINE_JSON;
+    /* A comma in the first token; a request's stacks=LIST comes later */
+    return line[strcspn(line, ", \t\r\n")] == ',' ? PA_LINE_CSV : PA_LINE_REQUEST;
+}
+
+/* Copy the value of "key" in a flat JSON object into out; false if absent */
+static bool json_field(const char *line, const char *key, char *out, size_t outlen)
+{
+    char pat[32];
+    snprintf(pat, sizeof(pat), "\"%s\"", key);
+    const char *p = strstr(line, pat);
+    if (!p) return false;
+    p += strlen(pat);
+    p += strspn(p, " \t");
+    if (*p++ != ':') return false;
+    p += strspn(p, " \t");
+
+    size_t len = (*p == '"') ? strcspn(++p, "\"") : strcspn(p, ",} \t\r\n");
+    if (len >= outlen) return false;
+    memcpy(out, p, len);
+    out[len] = '\0';
+    return true;
+}
+
+/*
+ * Turn one spot line into a request. CSV and JSON fields are rewritten
+ * as request tokens ("AhKh" -> "Ah" "Kh") so parse_request() does all
+ * the checking.
+ */
+static bool parse_spot(char *line, request_t *req, char *err, size_t errlen)
+{
+    char field[5][64], buf[PA_MAX_LINE], *tok[SPOT_MAX_TOKS], *save = NULL;
+    int nfield = 0, ntok = 0;
+    size_t used = 0;
+    pa_line_format_t fmt = spot_format(line);
+
+    if (fmt == PA_LINE_REQUEST) {
+        for (char *t = strtok_r(line, " \t\r\n", &save); t && ntok < SPOT_MAX_TOKS;
+             t = strtok_r(NULL, " \t\r\n", &save))
+            tok[ntok++] = t;
+        return parse_request(tok, ntok, req, err, errlen);
+    }
+
+    static const char *keys[5] = {"hole", "board", "pot", "to_call", "opponents"};
+    if (fmt == PA_LINE_JSON) {
+        for (nfield = 0; nfield < 5; nfield++)
+            if (!json_field(line, keys[nfield], field[nfield], sizeof(field[0])))
+                field[nfield][0] = '\0';
+    } else {
+        for (char *p = line; p && nfield < 5; nfield++) {
+            size_t len = strcspn(p, ",\r\n");
+            if (len >= sizeof(field[0])) len = sizeof(field[0]) - 1;
+            memcpy(field[nfield], p, len);
+            field[nfield][len] = '\0';
+            p = (p[strcspn(p, ",")] == ',') ? p + strcspn(p, ",") + 1 : NULL;
+        }
+        for (; nfield < 5; nfield++) field[nfield][0] = '\0';
+    }
+
+    /* Cards two characters at a time, then the numbers */
+    for (int f = 0; f < 2; f++)
+        for (const char *c = field[f]; c[0] && c[1] && ntok < SPOT_MAX_TOKS; c += 2) {
+            tok[ntok++] = buf + used;
+            buf[used++] = c[0]; buf[used++] = c[1]; buf[used++] = '\0';
+        }
+    for (int f = 2; f < 5 && ntok < SPOT_MAX_TOKS; f++) {
+        if (!field[f][0]) continue;
+        int len = snprintf(buf + used, sizeof(buf) - used, "%s%s", f == 4 ? "opponents=" : "", field[f]);
+        tok[ntok++] = buf + used;
+        used += (size_t)len + 1;
+    }
+    if (strlen(field[0]) == 8 && ntok < SPOT_MAX_TOKS) {
+        tok[ntok++] = buf + used;
+        used += (size_t)snprintf(buf + used, sizeof(buf) - used, "game=omaha") + 1;
+    }
+    return parse_request(tok, ntok, req, err, errlen);
+}
+
+/*
+ * Suit-isomorphic spots.
+ *
+ * Equity does not change when the suits are relabeled: AhKh on Qh Jh 2c
+ * is AsKs on Qs Js 2d. A spot's canonical form sorts the four suits by
+ * their hole cards, then their board cards, each read as a 13-bit face
+ * mask; suits that tie are identical, so the order among them does not
+ * matter and every relabeling of a spot gets the same form.
+ */
+static void canonical_spot(cardmask_t *hole, cardmask_t *board)
+{
+    uint64_t col[4];
+    for (int s = 0; s < 4; s++)
+        col[s] = ((*hole >> (13 * s)) & 0x1FFF) << 13 | ((*board >> (13 * s)) & 0x1FFF);
+    for (int i = 1; i < 4; i++)   /* insertion sort, largest first */
+        for (int j = i; j > 0 && col[j] > col[j-1]; j--) {
+            uint64_t t = col[j]; col[j] = col[j-1]; col[j-1] = t;
+        }
+    *hole = *board = 0;
+    for (int s = 0; s < 4; s++) {
+        *hole |= (col[s] >> 13) << (13 * s);
+        *board |= (col[s] & 0x1FFF) << (13 * s);
+    }
+}
+
+/*
+ * Equity cache.
+ *
+ * A context built with cache_entries > 0 remembers the answers to that
+ * many spots, keyed on the canonical spot and every setting that changes
+ * the answer, and evicts the least recently used. A cached spot without
+ * its own seed is seeded from its key rather than from the caller's
+ * rng, so whichever relabeling arrives first computes the same answer
+ * and results stay independent of the order spots are asked in. Spots
+ * with opponent ranges are not cached: a range names suits. Nor are
+ * spots with stacks, which are rarely asked twice.
+ */
+typedef struct {
+    cardmask_t hole, board;     /* canonical */
+    int        opponents, trials, hist_samples, threads;
+    int        stratified, omaha;   /* (no padding for memcmp() to read) */
+    uint64_t   seed;            /* 0: seeded from the key */
+} cache_key_t;
+
+typedef struct {
+    cache_key_t key;
+    uint64_t    hash;
+    answer_t    ans;
+    int         prev, next;     /* recency list, most recent first */
+    int         chain;          /* next entry in the same bucket */
+} cache_entry_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int             capacity, used;
+    int             num_buckets;   /* a power of two */
+    int            *bucket;        /* first entry of each chain, -1: none */
+    cache_entry_t  *entry;
+    int             head, tail;    /* most and least recently used */
+    long            hits, misses;
+} equity_cache_t;
+
+static uint64_t cache_hash(const cache_key_t *k)
+{
+    uint64_t w[4] = {k->hole, k->board,
+                     (uint64_t)k->opponents << 48 ^ (uint64_t)k->hist_samples << 24 ^ (uint64_t)k->threads,
+                     ((uint64_t)k->trials << 2 | (uint64_t)k->omaha << 1 | (uint64_t)k->stratified) ^
+                         k->seed * 0x9E3779B97F4A7C15ULL};
+    uint64_t h = 0;
+    for (int i = 0; i < 4; i++) {   /* splitmix64's finalizer over each word */
+        h = (h ^ w[i]) + 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+static equity_cache_t *cache_new(int capacity)
+{
+    equity_cache_t *c = calloc(1, sizeof(equity_cache_t));
+    pthread_mutex_init(&c->lock, NULL);
+    c->capacity = capacity;
+    for (c->num_buckets = 1; c->num_buckets < capacity; c->num_buckets <<= 1) {}
+    c->bucket = malloc(sizeof(int) * (size_t)c->num_buckets);
+    for (int b = 0; b < c->num_buckets; b++) c->bucket[b] = -1;
+    c->entry = malloc(sizeof(cache_entry_t) * (size_t)capacity);
+    c->head = c->tail = -1;
+    return c;
+}
+
+static void cache_free(equity_cache_t *c)
+{
+    if (!c) return;
+    pthread_mutex_destroy(&c->lock);
+    free(c->bucket);
+    free(c->entry);
+    free(c);
+}
+
+static void cache_unlink(equity_cache_t *c, int i)
+{
+    cache_entry_t *e = &c->entry[i];
+    if (e->prev >= 0) c->entry[e->prev].next = e->next; else c->head = e->next;
+    if (e->next >= 0) c->entry[e->next].prev = e->prev; else c->tail = e->prev;
+}
+
+static void cache_push_front(equity_cache_t *c, int i)
+{
+    c->entry[i].prev = -1;
+    c->entry[i].next = c->head;
+    if (c->head >= 0) c->entry[c->head].prev = i; else c->tail = i;
+    c->head = i;
+}
+
+/* Copy the answer for key into ans and mark it most recent; false if absent */
+static bool cache_get(equity_cache_t *c, const cache_key_t *key, uint64_t hash, answer_t *ans)
+{
+    pthread_mutex_lock(&c->lock);
+    int i = c->bucket[hash & (uint64_t)(c->num_buckets - 1)];
+    while (i >= 0 && (c->entry[i].hash != hash || memcmp(&c->entry[i].key, key, sizeof(*key)) != 0))
+        i = c->entry[i].chain;
+    if (i >= 0) {
+        *ans = c->entry[i].ans;
+        cache_unlink(c, i);
+        cache_push_front(c, i);
+        c->hits++;
+    } else {
+        c->misses++;
+    }
+    pthread_mutex_unlock(&c->lock);
+    return i >= 0;
+}
+
+/* Remember ans for key, evicting the least recently used entry when full */
+static void cache_put(equity_cache_t *c, const cache_key_t *key, uint64_t hash, const answer_t *ans)
+{
+    pthread_mutex_lock(&c->lock);
+    int *link = &c->bucket[hash & (uint64_t)(c->num_buckets - 1)];
+    for (int i = *link; i >= 0; i = c->entry[i].chain)
+        if (c->entry[i].hash == hash && memcmp(&c->entry[i].key, key, sizeof(*key)) == 0) {
+            pthread_mutex_unlock(&c->lock);   /* another thread got here first */
+            return;
+        }
+
+    int i;
+    if (c->used < c->capacity) {
+        i = c->used++;
+    } else {
+        i = c->tail;
+        cache_unlink(c, i);
+        int *p = &c->bucket[c->entry[i].hash & (uint64_t)(c->num_buckets - 1)];
+        while (*p != i) p = &c->entry[*p].chain;
+        *p = c->entry[i].chain;
+    }
+    c->entry[i].key = *key;
+    c->entry[i].hash = hash;
+    c->entry[i].ans = *ans;
+    c->entry[i].chain = *link;
+    *link = i;
+    cache_push_front(c, i);
+    pthread_mutex_unlock(&c->lock);
+}
+
+/*
+ * A context: the defaults for every spot, read-only once built apart
+ * from the equity cache, which has its own lock
+ */
+struct pa_context {
+    sim_opts_t      opts;       /* seed is drawn per spot */
+    range_t        *ranges;     /* the configured opponent ranges, NULL: random */
+    preflop_table_t preflop;
+    equity_cache_t *cache;      /* NULL: off */
+};
+
+_Static_assert(sizeof(pa_rng_t) == sizeof(rng_t), "pa_rng_t carries an rng_t");
+
+/*
+ * Equity from the cache or the preflop table when they cover the spot,
+ * else simulate(). A spot without a seed draws one from rng (when it is
+ * cached, from its key).
+ */
+static bool answer_equity(const pa_context_t *ctx, const request_t *req, pa_rng_t *rng,
+                          answer_t *ans, char *err, size_t errlen)
+{
+    sim_opts_t opts = ctx->opts;
+    const preflop_entry_t *pf = NULL;
+    const card_t *hole = req->hole;
+    range_t *ranges = NULL;
+    cache_key_t key;
+    uint64_t hash = 0;
+
+    memset(ans, 0, sizeof(*ans));
+    if (!check_cards(req, err, errlen)) return false;
+    if (req->num_community == 1 || req->num_community == 2) {
+        snprintf(err, errlen, "community cards must be 0 (pre-flop), 3 (flop), 4 (turn), or 5 (river).");
+        return false;
+    }
+    if (req->opponents < 0 || req->opponents > MAX_OPPONENTS || req->samples < 0 ||
+        req->histogram < 0 || req->threads < 0 || req->threads > MAX_THREADS ||
+        req->sampling < PA_SAMPLE_DEFAULT || req->sampling > PA_SAMPLE_STRATIFIED) {
+        snprintf(err, errlen, "opponents, samples, histogram, threads or sampling out of range.");
+        return false;
+    }
+    if (req->opponents) opts.opponents = req->opponents;
+    if (req->samples) opts.trials = req->samples;
+    if (req->histogram) opts.hist_samples = req->histogram;
+    if (req->threads) opts.threads = req->threads;
+    if (req->sampling) opts.stratified = req->sampling == PA_SAMPLE_STRATIFIED;
+    opts.omaha = req->game == PA_GAME_OMAHA;
+    if (opts.omaha && (req->range || opts.num_ranges)) {
+        snprintf(err, errlen, "opponent ranges are for hold'em hands.");
+        return false;
+    }
+    if (req->num_stacks) {
+        bool ok = req->num_stacks == opts.opponents + 1;
+        for (int i = 0; ok && i < req->num_stacks; i++) ok = req->stacks[i] > 0;
+        if (!ok) {
+            snprintf(err, errlen, "stacks needs %d positive chip counts, the hero's and one per opponent.",
+                opts.opponents + 1);
+            return false;
+        }
+        opts.stacks = req->stacks;
+        opts.pot = req->pot;
+    }
+
+    /* Cached spots are simulated in their canonical form */
+    cardmask_t hole_mask = cards_mask(hole, HOLE_CARDS(req));
+    cardmask_t board_mask = cards_mask(req->community, req->num_community);
+    bool cached = ctx->cache && !req->range && opts.num_ranges == 0 && !opts.stacks;
+    if (cached) {
+        memset(&key, 0, sizeof(key));
+        key.hole = hole_mask;
+        key.board = board_mask;
+        canonical_spot(&key.hole, &key.board);
+        key.opponents = opts.opponents;
+        key.trials = opts.trials;
+        key.hist_samples = opts.hist_samples;
+        key.threads = opts.threads;
+        key.stratified = opts.stratified;
+        key.omaha = opts.omaha;
+        key.seed = req->seed;
+        hash = cache_hash(&key);
+        if (cache_get(ctx->cache, &key, hash, ans)) {
+            ans->cached = true;
+            return true;
+        }
+        hole_mask = key.hole;
+        board_mask = key.board;
+    }
+
+    if (req->seed) {
+        opts.seed = req->seed;
+    } else if (cached) {
+        opts.seed = hash;
+    } else {
+        rng_t r;
+        memcpy(&r, rng, sizeof(r));
+        opts.seed = rng_next(&r);
+        memcpy(rng, &r, sizeof(r));
+    }
+    if (req->range) {
+        ranges = malloc(sizeof(range_t) * MAX_OPPONENTS);
+        opts.num_ranges = range_parse(ranges, req->range, err, errlen);
+        opts.ranges = ranges;
+        if (opts.num_ranges == 0) {
+            free(ranges);
+            return false;
+        }
+    }
+    ans->opponents = opts.opponents;
+
+    /* The table assumes random hold'em opponents and holds no histogram or pots */
+    const preflop_table_t *preflop = &ctx->preflop;
+    if (req->num_community == 0 && opts.num_ranges == 0 && opts.hist_samples == 0 && !opts.stacks &&
+        !opts.omaha)
+        pf = preflop_lookup(preflop, hole, opts.opponents);
+    if (pf) {
+        ans->win_pct = pf->equity;
+        ans->sim.method = PA_TABLE;
+        ans->sim.stop = PA_STOP_DONE;
+        ans->sim.outcomes = pf->samples;
+        ans->sim.std_error = pf->std_error;
+        ans->sim.sampling = PA_SAMPLE_PLAIN;
+        ans->sim.variance_reduction = 1.0;
+        /* Fewer opponents from their own entries, else as if independent */
+        ans->sim.eq_vs[0] = 1.0;
+        for (int k = 1; k <= opts.opponents; k++) {
+            const preflop_entry_t *e = preflop_lookup(preflop, hole, k);
+            ans->sim.eq_vs[k] = e ? e->equity : pow(pf->equity, (double)k / opts.opponents);
+        }
+        ans->current.rankVal = 9;
+        ans->current.high = (hole[0].face > hole[1].face) ? hole[0].face : hole[1].face;
+        ans->current.high2 = ans->current.kicker = -1;
+    } else {
+        ans->win_pct = simulate(hole_mask, board_mask, &ans->current, &opts, &ans->sim);
+    }
+    if (cached) cache_put(ctx->cache, &key, hash, ans);
+    free(ranges);
+    return true;
+}
+
+/*
+ * Public API (pokeradvisor.h)
+ */
+void pa_config_default(pa_config_t *cfg)
+{
+    sim_opts_t o = sim_opts_default();
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->opponents = o.opponents;
+    cfg->trials = o.trials;
+    cfg->threads = o.threads;
+    cfg->exact_budget = o.exact_budget;
+    cfg->target_se = o.target_se;
+    cfg->max_ms = o.max_ms;
+    cfg->hist_samples = o.hist_samples;
+    cfg->sampling = PA_SAMPLE_PLAIN;
+}
+
+/*
+ * A preflop table that cannot be opened is an error only when one was
+ * named; pa_context_has_preflop() tells whether spots can use it.
+ */
+pa_context_t *pa_context_new(const pa_config_t *cfg, char *err, size_t errlen)
+{
+    if (cfg->opponents < 1 || cfg->opponents > MAX_OPPONENTS) {
+        snprintf(err, errlen, "opponents must be between 1 and %d.", MAX_OPPONENTS);
+        return NULL;
+    }
+    if (cfg->threads < 1 || cfg->threads > MAX_THREADS) {
+        snprintf(err, errlen, "threads must be between 1 and %d.", MAX_THREADS);
+        return NULL;
+    }
+    if (cfg->trials < 1 || cfg->hist_samples < 0) {
+        snprintf(err, errlen, "the sample cap must be at least 1.");
+        return NULL;
+    }
+    if (cfg->cache_entries < 0 || cfg->cache_entries > PA_MAX_CACHE_ENTRIES) {
+        snprintf(err, errlen, "cache entries must be between 0 and %d.", PA_MAX_CACHE_ENTRIES);
+        return NULL;
+    }
+
+    pa_context_t *ctx = calloc(1, sizeof(pa_context_t));
+    eval_init();
+    ctx->opts = sim_opts_default();
+    ctx->opts.opponents = cfg->opponents;
+    ctx->opts.trials = cfg->trials;
+    ctx->opts.threads = cfg->threads;
+    ctx->opts.exact_budget = cfg->exact_budget;
+    ctx->opts.target_se = cfg->target_se;
+    ctx->opts.max_ms = cfg->max_ms;
+    ctx->opts.hist_samples = cfg->hist_samples;
+    ctx->opts.stratified = cfg->sampling == PA_SAMPLE_STRATIFIED;
+    if (cfg->cache_entries > 0) ctx->cache = cache_new(cfg->cache_entries);
+    if (cfg->range) {
+        ctx->ranges = malloc(sizeof(range_t) * MAX_OPPONENTS);
+        ctx->opts.num_ranges = range_parse(ctx->ranges, cfg->range, err, errlen);
+        ctx->opts.ranges = ctx->ranges;
+        if (ctx->opts.num_ranges == 0) {
+            pa_context_free(ctx);
+            return NULL;
+        }
+    }
+    if (cfg->preflop_table && !preflop_table_open(&ctx->preflop, cfg->preflop_table)) {
+        snprintf(err, errlen, "cannot use preflop table %s.", cfg->preflop_table);
+        pa_context_free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+void pa_context_free(pa_context_t *ctx)
+{
+    if (!ctx) return;
+    preflop_table_close(&ctx->preflop);
+    free(ctx->ranges);
+    cache_free(ctx->cache);
+    free(ctx);
+}
+
+bool pa_context_has_preflop(const pa_context_t *ctx)
+{
+    return ctx->preflop.entries != NULL;
+}
+
+void pa_context_cache_stats(const pa_context_t *ctx, long *hits, long *misses)
+{
+    *hits = *misses = 0;
+    if (!ctx->cache) return;
+    pthread_mutex_lock(&ctx->cache->lock);
+    *hits = ctx->cache->hits;
+    *misses = ctx->cache->misses;
+    pthread_mutex_unlock(&ctx->cache->lock);
+}
+
+void pa_rng_seed(pa_rng_t *rng, uint64_t seed)
+{
+    rng_t r;
+    rng_seed(&r, seed);
+    memcpy(rng, &r, sizeof(r));
+}
+
+bool pa_card_parse(const char *s, pa_card_t *c)
+{
+    return parse_card(s, c);
+}
+
+void pa_card_format(pa_card_t c, char out[4])
+{
+    snprintf(out, 4, "%s%c", face_str(c.face), suit_char(c.suit));
+}
+
+const char *pa_rank_name(int rankVal)
+{
+    return (rankVal >= 0 && rankVal < NUM_RANKS) ? RANK_NAMES[rankVal] : "N/A";
+}
+
+void pa_hand_class(const pa_card_t hole[2], char name[4])
+{
+    preflop_class_name(preflop_class(hole[0], hole[1]), name);
+}
+
+bool pa_spot_parse(char **tok, int ntok, pa_spot_t *spot, char *err, size_t errlen)
+{
+    return parse_request(tok, ntok, spot, err, errlen);
+}
+
+pa_line_format_t pa_spot_line_format(const char *line)
+{
+    return spot_format(line);
+}
+
+bool pa_spot_parse_line(char *line, pa_spot_t *spot, char *err, size_t errlen)
+{
+    return parse_spot(line, spot, err, errlen);
+}
+
+bool pa_rank(const pa_card_t *cards, int n, pa_rank_t *out)
+{
+    request_t r = {0};
+    char err[64];
+
+    if (n < 5 || n > 7) return false;
+    r.hole[0] = cards[0];
+    r.hole[1] = cards[1];
+    r.num_community = n - 2;
+    memcpy(r.community, cards + 2, sizeof(card_t) * (size_t)(n - 2));
+    if (!check_cards(&r, err, sizeof(err))) return false;
+    eval_init();
+    *out = best_hand(cards_mask(cards, n));
+    return true;
+}
+
+bool pa_equity(const pa_context_t *ctx, const pa_spot_t *spot, pa_rng_t *rng,
+               pa_answer_t *ans, char *err, size_t errlen)
+{
+    return answer_equity(ctx, spot, rng, ans, err, errlen);
+}
+
+/*
+ * The most the hero can raise over the call: with stacks, the effective
+ * stack (the hero's, or the biggest opponent's if smaller) less the call
+ */
+static int max_raise(const request_t *req)
+{
+    if (!req->num_stacks) return INT_MAX;
+    int deepest = 0;
+    for (int i = 1; i < req->num_stacks; i++)
+        if (req->stacks[i] > deepest) deepest = req->stacks[i];
+    int effective = req->stacks[0] < deepest ? req->stacks[0] : deepest;
+    return effective > req->to_call ? effective - req->to_call : 0;
+}
+
+bool pa_advise(const pa_context_t *ctx, const pa_spot_t *spot, pa_rng_t *rng,
+               pa_answer_t *ans, char *err, size_t errlen)
+{
+    if (!answer_equity(ctx, spot, rng, ans, err, errlen)) return false;
+    count_outs(cards_mask(spot->hole, HOLE_CARDS(spot)), cards_mask(spot->community, spot->num_community),
+        spot->game == PA_GAME_OMAHA, &ans->outs);
+    ans->advice = recommend(ans->sim.eq_vs, ans->opponents, spot->pot, spot->to_call, BIG_BLIND,
+                            max_raise(spot));
+    return true;
+}
@@ -5,430 +5,670 @@
 
   Monte Carlo poker hand strength estimator and betting advisor.
   Given hole cards and community cards, simulates random completions
-  to estimate win probability and recommend optimal action.
+  to estimate win probability, then recommends whichever of fold,
+  check/call and a range of raise sizes has the highest expected value.
 
-  Build:  gcc -O2 -o poker_advisor poker_advisor.c -lm
-  Usage:  ./poker_advisor <hole1> <hole2> [community1..5] [pot] [to_call]
+  This file is the command-line, server and batch front end; the work
+  is done by libpokeradvisor (pokeradvisor.h).
+
+  Build:  gcc -O2 -pthread -o poker_advisor poker_advisor.c libpokeradvisor.c -lm
+  Usage:  ./poker_advisor [options] <hole1> <hole2> [community1..5] [pot] [to_call]
+          ./poker_advisor --game omaha [options] <hole1..4> [community1..5] [pot] [to_call]
   Cards:  2h 3s Tc Ad Kc Qd Jh etc.
 
+  Options:
+    --opponents N opponents at the table, 1 to 9 (default 3)
+    --threads N   split the trials across N worker threads (default 1)
+    --seed S      master RNG seed; a given (seed, threads) pair always
+                  reproduces the same equity (default: from the clock)
+    --exact-budget N
+                  enumerate every showdown instead of sampling when there
+                  are at most N of them (default 1000000, 0 = never)
+    --target-se P stop sampling once the equity's standard error is at
+                  most P percentage points (default 0.5, 0 = off)
+    --max-samples N
+                  hard cap on Monte Carlo trials (default 10000)
+    --max-ms T    hard cap on sampling wall time in ms (default none)
+    --preflop-table FILE
+                  answer preflop queries from a table written by
+                  preflop_table_gen (default ./preflop_equity.bin if present)
+    --server      read requests from stdin, one per line, and write one
+                  JSON result line per request
+    --socket PATH same, serving each client of a Unix-domain socket
+    --batch FILE  score every spot in FILE ("-" for stdin) in parallel
+                  across spots, --threads N at a time (default all cores);
+                  see run_batch() for the formats
+    --range SPEC  opponents hold hands from SPEC instead of random hands,
+                  e.g. "QQ+,AKs,ATo+" or "top15%"; "/" separates one
+                  range per opponent, the last repeating
+    --histogram N also report how the equity spreads once the next street
+                  is out, from N nested samples per trial (e.g. 50)
+    --sampling M  plain (default) or stratified: cycle the trials through
+                  every turn and river (on the flop) or river (on the
+                  turn) so the board adds no sampling noise; reports the
+                  variance reduction
+    --cache N     remember the answers to N spots, so a spot repeated up
+                  to a relabeling of suits is not simulated again
+                  (default 4096 with --server, --socket and --batch,
+                  0 = off); cached spots are seeded from the spot itself
+    --stacks LIST chips the hero and each opponent still put in, all in,
+                  e.g. 500,300,800: also report what the hero expects
+                  back from the main and side pots
+    --game G      holdem (default) or omaha: four hole cards, of which a
+                  hand uses exactly two
+
   Example:
     ./poker_advisor Ah Kh Qh Jh 2c 150 40
     -> Evaluates A♥ K♥ as hole, Q♥ J♥ 2♣ as flop, pot=150, to_call=40
+
+  Server request lines use the same order, plus optional key=value fields
+  opponents=N, samples=N, seed=S, range=SPEC, histogram=N,
+  sampling=plain|stratified, stacks=LIST and game=holdem|omaha:
+    Ah Kh Qh Jh 2c 150 40 opponents=2 samples=5000 range=QQ+,AKs
 ********************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <signal.h>
 
-#define DECK_SIZE       52
-#define HAND_SIZE       5
-#define NUM_OPPONENTS   3
-#define NUM_SIMULATIONS 10000
-#define NUM_RANKS       10
+#include "pokeradvisor.h"
 
-typedef struct {
-    int face; /* 0=2, 1=3, ..., 12=A */
-    int suit; /* 0=heart, 1=spade, 2=club, 3=diamond */
-} card_t;
+#define PREFLOP_FILE      "preflop_equity.bin"
+#define CACHE_ENTRIES     4096   /* default equity cache for the server and batch modes */
 
-typedef struct {
-    int rankVal;  /* 0=Royal Flush .. 9=High Card */
-    int high;
-    int high2;
-    int kicker;
-} rank_t;
-
-static const char *RANK_NAMES[NUM_RANKS] = {
-    "Royal Flush", "Straight Flush", "Four of a Kind", "Full House",
-    "Flush", "Straight", "Three of a Kind", "Two Pair", "One Pair", "High Card"
-};
-
-/* Parse a card string like "Ah" "Tc" "2d" */
-static bool parse_card(const char *s, card_t *c)
+/*
+ * Server mode: one request per input line, one JSON result per output
+ * line, e.g.
+ *   > Ah Kh Qh Jh 2c 150 40 opponents=2 samples=5000
+ *   < {"equity":0.6934,"ci95":0.0128,"samples":5000,"method":"monte_carlo",...}
+ * Requests without seed= draw seeds from the configured seed plus a
+ * request counter, so a replayed session reproduces its answers.
+ */
+#define REQUEST_MAX_LINE  PA_MAX_LINE
+#define REQUEST_MAX_TOKS  32
+
+static uint64_t request_seq;   /* shared by every connection */
+
+static const char *METHOD_NAMES[] = {"monte_carlo", "exact", "preflop_table"};
+
+/*
+ * A JSON string, quoted, with '"', '\\' and control characters escaped.
+ * Error messages repeat the client's tokens, so nothing goes out raw.
+ */
+static void print_json_string(FILE *out, const char *s)
 {
-    switch (s[0]) {
-        case '2': c->face = 0; break;
-        case '3': c->face = 1; break;
-        case '4': c->face = 2; break;
-        case '5': c->face = 3; break;
-        case '6': c->face = 4; break;
-        case '7': c->face = 5; break;
-        case '8': c->face = 6; break;
-        case '9': c->face = 7; break;
-        case 'T': case 't': c->face = 8; break;
-        case 'J': case 'j': c->face = 9; break;
-        case 'Q': case 'q': c->face = 10; break;
-        case 'K': case 'k': c->face = 11; break;
-        case 'A': case 'a': c->face = 12; break;
-        default: return false;
-    }
-    switch (s[1]) {
-        case 'h': case 'H': c->suit = 0; break;
-        case 's': case 'S': c->suit = 1; break;
-        case 'c': case 'C': c->suit = 2; break;
-        case 'd': case 'D': c->suit = 3; break;
-        default: return false;
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if (c < 0x20) fprintf(out, "\\u%04x", c);
+        else fputc(c, out);
     }
-    return true;
+    fputc('"', out);
 }
 
-static const char *face_str(int f)
+static void print_error_json(FILE *out, const char *err)
 {
-    static const char *names[] = {"2","3","4","5","6","7","8","9","T","J","Q","K","A"};
-    return names[f];
+    fprintf(out, "{\"error\":");
+    print_json_string(out, err);
+    fprintf(out, "}\n");
 }
 
-static char suit_char(int s)
+/* One answer; a spot with stacks always reports "chips", even 0 */
+static void print_answer_json(FILE *out, const pa_answer_t *ans, bool stacked)
 {
-    return "hscd"[s];
+    const pa_advice_t *a = &ans->advice;
+    const pa_sim_t *sim = &ans->sim;
+
+    fprintf(out, "{\"equity\":%.4f,\"ci95\":%.4f,\"samples\":%ld,\"evaluations\":%ld,"
+        "\"dropped\":%ld,\"method\":\"%s\",\"opponents\":%d,\"hand\":",
+        ans->win_pct, 1.96 * ans->sim.std_error, ans->sim.outcomes, ans->sim.evaluations,
+        ans->sim.dropped, METHOD_NAMES[ans->sim.method], ans->opponents);
+    print_json_string(out, pa_rank_name(ans->current.rankVal));
+    fprintf(out, ",\"strength\":");
+    print_json_string(out, a->strength);
+    fprintf(out, ",\"action\":");
+    print_json_string(out, a->action);
+    fprintf(out, ",\"amount\":%d", a->amount);
+    fprintf(out, ",\"ev\":%.2f,\"ev_call\":%.2f,\"ev_raise\":[", a->ev, a->ev_call);
+    for (int i = 0, n = 0; i < PA_NUM_RAISE_SIZES; i++)   /* none when all in */
+        if (a->raise[i] > 0) fprintf(out, "%s[%d,%.2f]", n++ ? "," : "", a->raise[i], a->ev_raise[i]);
+    fprintf(out, "]");
+    if (sim->hist_trials) {
+        fprintf(out, ",\"histogram\":[");
+        for (int b = 0; b < PA_EQUITY_BUCKETS; b++)
+            fprintf(out, "%s%.4f", b ? "," : "", (double)sim->hist[b] / sim->hist_trials);
+        fprintf(out, "],\"hist_mean\":%.4f,\"hist_sd\":%.4f", sim->hist_mean, sim->hist_sd);
+    }
+    if (ans->outs.unseen) {
+        const pa_outs_t *o = &ans->outs;
+        fprintf(out, ",\"outs\":%d,\"outs_by\":{", o->outs);
+        for (int r = 0, n = 0; r < PA_NUM_RANKS; r++)
+            if (o->by_rank[r]) {
+                fprintf(out, "%s", n++ ? "," : "");
+                print_json_string(out, pa_rank_name(r));
+                fprintf(out, ":%d", o->by_rank[r]);
+            }
+        fprintf(out, "},\"improve_next\":%.4f,\"improve_river\":%.4f", o->improve_next, o->improve_river);
+    }
+    if (sim->sampling == PA_SAMPLE_STRATIFIED)
+        fprintf(out, ",\"sampling\":\"stratified\",\"variance_reduction\":%.2f", sim->variance_reduction);
+    if (stacked) fprintf(out, ",\"chips\":%.2f", sim->chips);
+    if (ans->cached) fprintf(out, ",\"cached\":true");
+    fprintf(out, "}\n");
 }
 
-/* Evaluate best 5-card hand from exactly 5 cards */
-static rank_t rank_hand(card_t hand[5])
+static void serve_stream(FILE *in, FILE *out, const pa_context_t *ctx, uint64_t seed)
 {
-    rank_t r = {9, -1, -1, -1};
-    int faces[5], suits[5];
-    int i, j;
-
-    /* Sort by face */
-    for (i = 0; i < 5; i++) { faces[i] = hand[i].face; suits[i] = hand[i].suit; }
-    for (i = 0; i < 4; i++)
-        for (j = i+1; j < 5; j++)
-            if (faces[j] < faces[i]) {
-                int tf = faces[i]; faces[i] = faces[j]; faces[j] = tf;
-                int ts = suits[i]; suits[i] = suits[j]; suits[j] = ts;
+    char line[REQUEST_MAX_LINE];
+
+    while (fgets(line, sizeof(line), in)) {
+        char *tok[REQUEST_MAX_TOKS], *save = NULL;
+        int ntok = 0;
+
+        /* A line that does not fit is one bad request, not two */
+        size_t len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len-1] != '\n') {
+            int c, rest = 0;
+            while ((c = getc(in)) != EOF && c != '\n') rest = 1;
+            if (rest) {
+                char err[64];
+                snprintf(err, sizeof(err), "request longer than %d bytes.", REQUEST_MAX_LINE - 1);
+                print_error_json(out, err);
+                fflush(out);
+                continue;
             }
+        }
+        for (char *t = strtok_r(line, " \t\r\n", &save); t && ntok < REQUEST_MAX_TOKS;
+             t = strtok_r(NULL, " \t\r\n", &save))
+            tok[ntok++] = t;
+        if (ntok == 0 || tok[0][0] == '#') continue;
+
+        pa_spot_t spot;
+        pa_answer_t ans;
+        pa_rng_t rng;
+        char err[128];
+        pa_rng_seed(&rng, seed + __atomic_fetch_add(&request_seq, 1, __ATOMIC_RELAXED));
+        if (!pa_spot_parse(tok, ntok, &spot, err, sizeof(err)) ||
+            !pa_advise(ctx, &spot, &rng, &ans, err, sizeof(err)))
+            print_error_json(out, err);
+        else
+            print_answer_json(out, &ans, spot.num_stacks > 0);
+        fflush(out);
+    }
+}
 
-    bool is_flush = (suits[0]==suits[1] && suits[1]==suits[2] && suits[2]==suits[3] && suits[3]==suits[4]);
+typedef struct {
+    int                 fd;
+    const pa_context_t *ctx;
+    uint64_t            seed;
+} connection_t;
 
-    bool is_straight = false;
-    int straight_high = -1;
-    bool consec = true;
-    for (i = 1; i < 5; i++) if (faces[i] != faces[i-1]+1) { consec = false; break; }
-    if (consec) { is_straight = true; straight_high = faces[4]; }
-    /* Wheel: A-2-3-4-5 */
-    if (!is_straight && faces[0]==0 && faces[1]==1 && faces[2]==2 && faces[3]==3 && faces[4]==12) {
-        is_straight = true; straight_high = 3;
-    }
+static void *serve_connection(void *arg)
+{
+    connection_t *c = arg;
+    FILE *in = fdopen(c->fd, "r");
+    FILE *out = fdopen(dup(c->fd), "w");
+
+    if (in && out) serve_stream(in, out, c->ctx, c->seed);
+    if (out) fclose(out);
+    if (in) fclose(in); else close(c->fd);
+    free(c);
+    return NULL;
+}
 
-    /* Count face occurrences */
-    int counts[13] = {0};
-    for (i = 0; i < 5; i++) counts[faces[i]]++;
-
-    typedef struct { int face, count; } group_t;
-    group_t groups[5];
-    int ng = 0;
-    for (i = 0; i < 13; i++) if (counts[i]) { groups[ng].face = i; groups[ng].count = counts[i]; ng++; }
-    /* Sort groups: by count desc, then face desc */
-    for (i = 0; i < ng-1; i++)
-        for (j = i+1; j < ng; j++)
-            if (groups[j].count > groups[i].count ||
-                (groups[j].count == groups[i].count && groups[j].face > groups[i].face)) {
-                group_t tmp = groups[i]; groups[i] = groups[j]; groups[j] = tmp;
-            }
+/* Accept clients on a Unix-domain socket, one thread per connection */
+static int serve_socket(const char *path, const pa_context_t *ctx, uint64_t seed)
+{
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
 
-    if (is_straight && is_flush) {
-        r.rankVal = (straight_high == 12) ? 0 : 1;
-        r.high = straight_high;
-        return r;
-    }
-    if (groups[0].count == 4) {
-        r.rankVal = 2; r.high = groups[0].face; r.kicker = groups[1].face; return r;
-    }
-    if (groups[0].count == 3 && ng > 1 && groups[1].count == 2) {
-        r.rankVal = 3; r.high = groups[0].face; r.high2 = groups[1].face; r.kicker = groups[1].face; return r;
-    }
-    if (is_flush) {
-        r.rankVal = 4; r.high = faces[4]; r.kicker = faces[3]; return r;
-    }
-    if (is_straight) {
-        r.rankVal = 5; r.high = straight_high; return r;
+    if (fd < 0 || strlen(path) >= sizeof(addr.sun_path)) {
+        printf("Error: cannot create socket %s.\n", path);
+        return 1;
     }
-    if (groups[0].count == 3) {
-        r.rankVal = 6; r.high = groups[0].face;
-        r.kicker = (ng > 1) ? groups[1].face : -1;
-        return r;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    /* Replace a stale socket, but nothing else */
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            printf("Error: %s exists and is not a socket.\n", path);
+            close(fd);
+            return 1;
+        }
+        unlink(path);
     }
-    if (groups[0].count == 2 && ng > 1 && groups[1].count == 2) {
-        int hp = groups[0].face > groups[1].face ? groups[0].face : groups[1].face;
-        int lp = groups[0].face < groups[1].face ? groups[0].face : groups[1].face;
-        r.rankVal = 7; r.high = hp; r.high2 = lp;
-        r.kicker = (ng > 2) ? groups[2].face : -1;
-        return r;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        printf("Error: cannot listen on %s.\n", path);
+        close(fd);
+        return 1;
     }
-    if (groups[0].count == 2) {
-        r.rankVal = 8; r.high = groups[0].face;
-        int best_k = -1;
-        for (i = 1; i < ng; i++) if (groups[i].face > best_k) best_k = groups[i].face;
-        r.kicker = best_k;
-        return r;
+    signal(SIGPIPE, SIG_IGN);   /* a client hanging up must not kill the server */
+
+    for (;;) {
+        int cfd = accept(fd, NULL, NULL);
+        if (cfd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                usleep(100000);   /* out of descriptors or memory: wait for clients to leave */
+                continue;
+            }
+            printf("Error: accept on %s failed: %s.\n", path, strerror(errno));
+            close(fd);
+            return 1;
+        }
+        connection_t *c = malloc(sizeof(connection_t));
+        pthread_t tid;
+        if (!c) {
+            close(cfd);
+            continue;
+        }
+        c->fd = cfd;
+        c->ctx = ctx;
+        c->seed = seed;
+        if (pthread_create(&tid, NULL, serve_connection, c) != 0) {
+            close(cfd);
+            free(c);
+            continue;
+        }
+        pthread_detach(tid);
     }
-    r.rankVal = 9; r.high = faces[4]; r.high2 = faces[3]; r.kicker = faces[2];
-    return r;
-}
-
-/* Compare two ranks: returns >0 if a wins, <0 if b wins, 0 if tie */
-static int compare_ranks(rank_t *a, rank_t *b)
-{
-    if (a->rankVal != b->rankVal) return a->rankVal < b->rankVal ? 1 : -1;
-    if (a->high != b->high) return a->high > b->high ? 1 : -1;
-    if (a->high2 != b->high2) return a->high2 > b->high2 ? 1 : -1;
-    if (a->kicker != b->kicker) return a->kicker > b->kicker ? 1 : -1;
     return 0;
 }
 
-/* Evaluate best 5 of N cards (N=5,6,7) */
-static rank_t best_hand(card_t *cards, int n)
-{
-    rank_t best = {10, -1, -1, -1};
-    int idx[5];
-    int a, b, c, d, e;
-
-    for (a = 0; a < n-4; a++)
-    for (b = a+1; b < n-3; b++)
-    for (c = b+1; c < n-2; c++)
-    for (d = c+1; d < n-1; d++)
-    for (e = d+1; e < n; e++) {
-        card_t hand5[5] = {cards[a], cards[b], cards[c], cards[d], cards[e]};
-        rank_t r = rank_hand(hand5);
-        if (compare_ranks(&r, &best) > 0)
-            best = r;
-    }
-    return best;
-}
+/*
+ * Batch mode: score a file of spots, one per line, in parallel across
+ * spots. A line is CSV "hole,board,pot,to_call[,opponents]" such as
+ * "AhKh,QhJh2c,150,40,3" (a header row starting with "hole" is skipped;
+ * four hole cards make an Omaha spot),
+ * a JSON object with the same keys, or a request line as in server mode
+ * (see pa_spot_parse_line()).
+ * Spots are read in chunks, answered by a pool of threads with one
+ * simulation thread each, and written in input order: CSV rows when the
+ * first spot is CSV, JSON lines otherwise. Spot k is seeded with the
+ * configured seed plus k, so the output does not depend on the pool size.
+ */
+#define BATCH_CHUNK  4096
+
+typedef struct {
+    char        line[REQUEST_MAX_LINE];
+    bool        ok;
+    bool        stacked;   /* the spot gave stacks */
+    char        err[128];
+    pa_answer_t ans;
+} batch_spot_t;
 
-/* Fisher-Yates partial shuffle: shuffle first n elements of deck */
-static void partial_shuffle(card_t *deck, int deck_size, int n)
+typedef struct {
+    batch_spot_t       *spots;
+    int                 count;
+    int                 next;      /* next spot to claim, shared by the pool */
+    uint64_t            first;     /* spot number of spots[0] */
+    const pa_context_t *ctx;
+    uint64_t            seed;
+} batch_t;
+
+static void *batch_worker(void *arg)
 {
-    for (int i = 0; i < n && i < deck_size-1; i++) {
-        int j = i + rand() % (deck_size - i);
-        card_t tmp = deck[i]; deck[i] = deck[j]; deck[j] = tmp;
+    batch_t *b = arg;
+    int i;
+
+    while ((i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED)) < b->count) {
+        batch_spot_t *s = &b->spots[i];
+        pa_spot_t spot;
+        pa_rng_t rng;
+
+        pa_rng_seed(&rng, b->seed + b->first + (uint64_t)i);
+        s->ok = pa_spot_parse_line(s->line, &spot, s->err, sizeof(s->err));
+        spot.threads = 1;
+        s->ok = s->ok && pa_advise(b->ctx, &spot, &rng, &s->ans, s->err, sizeof(s->err));
+        s->stacked = s->ok && spot.num_stacks > 0;
     }
+    return NULL;
 }
 
-/* Check if card is in the used set */
-static bool card_in_set(card_t *set, int n, card_t c)
+static void print_answer_csv(FILE *out, const batch_spot_t *s)
 {
-    for (int i = 0; i < n; i++)
-        if (set[i].face == c.face && set[i].suit == c.suit)
-            return true;
-    return false;
+    const pa_answer_t *ans = &s->ans;
+
+    if (!s->ok) {
+        fprintf(out, ",,,,,,,\"");
+        for (const char *c = s->err; *c; c++)   /* CSV doubles quotes */
+            fprintf(out, *c == '"' ? "\"\"" : "%c", *c);
+        fprintf(out, "\"\n");
+        return;
+    }
+    fprintf(out, "%.4f,%.4f,%ld,%s,%s,%s,%d,\n",
+        ans->win_pct, 1.96 * ans->sim.std_error, ans->sim.outcomes,
+        METHOD_NAMES[ans->sim.method], pa_rank_name(ans->current.rankVal),
+        ans->advice.action, ans->advice.amount);
 }
 
-/*
- * Monte Carlo simulation:
- * Given player's hole cards and current community cards,
- * simulate random completions and opponent hands.
- * Returns win probability (0.0 to 1.0).
- * Also fills out best_rank with current best hand info.
- */
-static double simulate(card_t hole[2], card_t *community, int num_community,
-                       rank_t *best_rank)
+static void run_batch(FILE *in, FILE *out, const pa_context_t *ctx, uint64_t seed, int nthreads)
 {
-    int wins = 0, ties = 0, total = 0;
-
-    /* Build remaining deck */
-    card_t used[9]; /* max: 2 hole + 5 community + 2 extra */
-    int num_used = 0;
-    for (int i = 0; i < 2; i++) used[num_used++] = hole[i];
-    for (int i = 0; i < num_community; i++) used[num_used++] = community[i];
-
-    card_t remaining[52];
-    int num_remaining = 0;
-    for (int s = 0; s < 4; s++)
-        for (int f = 0; f < 13; f++) {
-            card_t c = {f, s};
-            if (!card_in_set(used, num_used, c))
-                remaining[num_remaining++] = c;
+    batch_t b = {malloc(sizeof(batch_spot_t) * BATCH_CHUNK), 0, 0, 0, ctx, seed};
+    pthread_t tids[PA_MAX_THREADS];
+    int format = -1;
+
+    setvbuf(out, NULL, _IOFBF, 1 << 16);
+    for (;;) {
+        b.count = 0;
+        while (b.count < BATCH_CHUNK && fgets(b.spots[b.count].line, REQUEST_MAX_LINE, in)) {
+            const char *p = b.spots[b.count].line;
+            p += strspn(p, " \t");
+            if (*p == '\0' || *p == '\r' || *p == '\n' || *p == '#' || strncmp(p, "hole", 4) == 0)
+                continue;
+            if (format < 0) {
+                format = pa_spot_line_format(p);
+                if (format == PA_LINE_CSV)
+                    fprintf(out, "equity,ci95,samples,method,hand,action,amount,error\n");
+            }
+            b.count++;
         }
-
-    /* Current best hand if enough cards */
-    if (num_community >= 3) {
-        card_t all[7];
-        all[0] = hole[0]; all[1] = hole[1];
-        for (int i = 0; i < num_community; i++) all[2+i] = community[i];
-        *best_rank = best_hand(all, 2 + num_community);
-    } else {
-        best_rank->rankVal = 9;
-        best_rank->high = (hole[0].face > hole[1].face) ? hole[0].face : hole[1].face;
-        best_rank->high2 = -1;
-        best_rank->kicker = -1;
-    }
-
-    int cards_to_complete = 5 - num_community;             /* board cards needed */
-    int cards_needed = cards_to_complete + 2 * NUM_OPPONENTS; /* total random cards */
-
-    for (int sim = 0; sim < NUM_SIMULATIONS; sim++) {
-        partial_shuffle(remaining, num_remaining, cards_needed);
-
-        /* Complete community */
-        card_t full_community[5];
-        for (int i = 0; i < num_community; i++) full_community[i] = community[i];
-        for (int i = 0; i < cards_to_complete; i++) full_community[num_community+i] = remaining[i];
-
-        /* Player's best hand */
-        card_t player_cards[7] = {hole[0], hole[1],
-            full_community[0], full_community[1], full_community[2],
-            full_community[3], full_community[4]};
-        rank_t player_rank = best_hand(player_cards, 7);
-
-        /* Opponents' hands */
-        bool player_wins = true;
-        bool is_tie = false;
-        for (int opp = 0; opp < NUM_OPPONENTS; opp++) {
-            int base = cards_to_complete + opp * 2;
-            card_t opp_cards[7] = {remaining[base], remaining[base+1],
-                full_community[0], full_community[1], full_community[2],
-                full_community[3], full_community[4]};
-            rank_t opp_rank = best_hand(opp_cards, 7);
-            int cmp = compare_ranks(&player_rank, &opp_rank);
-            if (cmp < 0) { player_wins = false; break; }
-            if (cmp == 0) is_tie = true;
+        if (b.count == 0) break;
+
+        /* Answer the chunk: this thread plus nthreads-1 more */
+        int started = 1;
+        b.next = 0;
+        for (int t = 1; t < nthreads && t < b.count; t++, started++)
+            if (pthread_create(&tids[t], NULL, batch_worker, &b) != 0) break;
+        batch_worker(&b);
+        for (int t = 1; t < started; t++)
+            pthread_join(tids[t], NULL);
+
+        for (int i = 0; i < b.count; i++) {
+            const batch_spot_t *s = &b.spots[i];
+            if (format == PA_LINE_CSV) print_answer_csv(out, s);
+            else if (s->ok) print_answer_json(out, &s->ans, s->stacked);
+            else print_error_json(out, s->err);
         }
-
-        if (player_wins && !is_tie) wins++;
-        else if (player_wins && is_tie) ties++;
-        total++;
+        b.first += (uint64_t)b.count;
     }
-
-    return (double)wins / total + 0.5 * (double)ties / total;
+    fflush(out);
+    free(b.spots);
 }
 
-/* Recommend action based on win probability, pot, and amount to call */
-typedef struct {
-    const char *action;   /* "FOLD", "CHECK", "CALL", "RAISE" */
-    int         amount;   /* raise amount (0 if fold/check/call) */
-    double      win_pct;
-    const char *strength; /* "Very Strong", "Strong", "Medium", "Weak", "Very Weak" */
-} advice_t;
-
-static advice_t recommend(double win_pct, int pot, int to_call, int big_blind)
+int main(int argc, char *argv[])
 {
-    advice_t a;
-    a.win_pct = win_pct;
-    a.amount = 0;
-
-    /* Strength label */
-    if (win_pct >= 0.70)      a.strength = "Very Strong";
-    else if (win_pct >= 0.50) a.strength = "Strong";
-    else if (win_pct >= 0.35) a.strength = "Medium";
-    else if (win_pct >= 0.20) a.strength = "Weak";
-    else                      a.strength = "Very Weak";
-
-    /* Pot odds: need to_call to win pot+to_call */
-    double pot_odds = (to_call > 0) ? (double)to_call / (pot + to_call) : 0.0;
-
-    if (to_call == 0) {
-        /* No bet to match */
-        if (win_pct >= 0.65) {
-            a.action = "RAISE";
-            a.amount = (win_pct >= 0.80) ? big_blind * 4 :
-                       (win_pct >= 0.70) ? big_blind * 3 : big_blind * 2;
-        } else {
-            a.action = "CHECK";
-        }
-    } else {
-        /* Must call or fold */
-        if (win_pct < pot_odds * 0.9) {
-            a.action = "FOLD";
-        } else if (win_pct >= 0.65) {
-            a.action = "RAISE";
-            a.amount = (win_pct >= 0.80) ? big_blind * 4 :
-                       (win_pct >= 0.70) ? big_blind * 3 : big_blind * 2;
+    pa_config_t opts;
+    uint64_t seed = 0;
+    bool seed_given = false, threads_given = false, cache_given = false, server = false;
+    const char *preflop_path = NULL, *socket_path = NULL, *range_spec = NULL, *batch_path = NULL;
+    char err[128], stacks_arg[128] = "", game_arg[16] = "";
+
+    pa_config_default(&opts);
+
+    /* Pull --options out of argv, leaving the positional arguments */
+    int nargs = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--opponents") == 0 && i+1 < argc) {
+            opts.opponents = atoi(argv[++i]);
+            if (opts.opponents < 1 || opts.opponents > PA_MAX_OPPONENTS) {
+                printf("Error: --opponents must be between 1 and %d.\n", PA_MAX_OPPONENTS);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) {
+            opts.threads = atoi(argv[++i]);
+            if (opts.threads < 1 || opts.threads > PA_MAX_THREADS) {
+                printf("Error: --threads must be between 1 and %d.\n", PA_MAX_THREADS);
+                return 1;
+            }
+            threads_given = true;
+        } else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+            seed_given = true;
+        } else if (strcmp(argv[i], "--exact-budget") == 0 && i+1 < argc) {
+            opts.exact_budget = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--target-se") == 0 && i+1 < argc) {
+            opts.target_se = atof(argv[++i]) / 100.0;
+        } else if (strcmp(argv[i], "--max-samples") == 0 && i+1 < argc) {
+            opts.trials = atoi(argv[++i]);
+            if (opts.trials < 1) {
+                printf("Error: --max-samples must be at least 1.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--max-ms") == 0 && i+1 < argc) {
+            opts.max_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--preflop-table") == 0 && i+1 < argc) {
+            preflop_path = argv[++i];
+        } else if (strcmp(argv[i], "--server") == 0) {
+            server = true;
+        } else if (strcmp(argv[i], "--socket") == 0 && i+1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && i+1 < argc) {
+            batch_path = argv[++i];
+        } else if (strcmp(argv[i], "--range") == 0 && i+1 < argc) {
+            range_spec = argv[++i];
+            opts.range = range_spec;
+        } else if (strcmp(argv[i], "--sampling") == 0 && i+1 < argc) {
+            i++;
+            if (strcmp(argv[i], "plain") == 0) opts.sampling = PA_SAMPLE_PLAIN;
+            else if (strcmp(argv[i], "stratified") == 0) opts.sampling = PA_SAMPLE_STRATIFIED;
+            else {
+                printf("Error: --sampling must be plain or stratified.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cache") == 0 && i+1 < argc) {
+            opts.cache_entries = atoi(argv[++i]);
+            if (opts.cache_entries < 0 || opts.cache_entries > PA_MAX_CACHE_ENTRIES) {
+                printf("Error: --cache must be between 0 and %d.\n", PA_MAX_CACHE_ENTRIES);
+                return 1;
+            }
+            cache_given = true;
+        } else if (strcmp(argv[i], "--stacks") == 0 && i+1 < argc) {
+            snprintf(stacks_arg, sizeof(stacks_arg), "stacks=%s", argv[++i]);
+        } else if (strcmp(argv[i], "--game") == 0 && i+1 < argc) {
+            i++;
+            if (strcmp(argv[i], "holdem") != 0 && strcmp(argv[i], "omaha") != 0) {
+                printf("Error: --game must be holdem or omaha.\n");
+                return 1;
+            }
+            snprintf(game_arg, sizeof(game_arg), "game=%s", argv[i]);
+        } else if (strcmp(argv[i], "--histogram") == 0 && i+1 < argc) {
+            opts.hist_samples = atoi(argv[++i]);
+            if (opts.hist_samples < 1) {
+                printf("Error: --histogram must be at least 1.\n");
+                return 1;
+            }
         } else {
-            a.action = "CALL";
-            a.amount = to_call;
+            argv[nargs++] = argv[i];
         }
     }
-
-    return a;
-}
-
-int main(int argc, char *argv[])
-{
-    card_t hole[2];
-    card_t community[5];
-    int num_community = 0;
-    int pot = 0, to_call = 0;
-    int big_blind = 20;
-
-    if (argc < 3) {
-        printf("Usage: %s <hole1> <hole2> [community1..5] [pot] [to_call]\n", argv[0]);
+    if (stacks_arg[0]) argv[nargs++] = stacks_arg;   /* spot fields: passed on as such */
+    if (game_arg[0]) argv[nargs++] = game_arg;
+    argc = nargs;
+
+    if (argc < 3 && !server && !socket_path && !batch_path) {
+        printf("Usage: %s [options] <hole1> <hole2> [community1..5] [pot] [to_call]\n", argv[0]);
+        printf("       %s [options] --server | --socket PATH | --batch FILE\n", argv[0]);
+        printf("Options: --opponents N --threads N --seed S --exact-budget N --target-se P\n");
+        printf("         --max-samples N --max-ms T --preflop-table FILE --range SPEC\n");
+        printf("         --histogram N --sampling M --cache N --stacks LIST --game G\n");
         printf("Cards: 2h 3s Tc Ad Kc Qd Jh etc.\n");
         printf("Example: %s Ah Kh Qh Jh 2c 150 40\n", argv[0]);
         return 1;
     }
 
-    srand((unsigned)time(NULL));
+    if (!seed_given)
+        seed = (uint64_t)time(NULL) ^ ((uint64_t)clock() << 32);
+
+    /* Only the server and batch modes see a spot twice */
+    if (!cache_given && (server || socket_path || batch_path))
+        opts.cache_entries = CACHE_ENTRIES;
 
-    /* Parse hole cards */
-    if (!parse_card(argv[1], &hole[0]) || !parse_card(argv[2], &hole[1])) {
-        printf("Error: invalid hole card format.\n");
+    /* Check the settings without the preflop table first, so that only a
+     * table that fails to load falls back to simulating. A missing default
+     * table is normal and needs no warning. */
+    opts.preflop_table = NULL;
+    pa_context_t *ctx = pa_context_new(&opts, err, sizeof(err));
+    if (!ctx) {
+        printf("Error: %s\n", err);
         return 1;
     }
-
-    /* Parse remaining args: community cards first, then numeric pot/to_call */
-    int arg_idx = 3;
-    while (arg_idx < argc && num_community < 5) {
-        card_t c;
-        if (parse_card(argv[arg_idx], &c)) {
-            community[num_community++] = c;
-            arg_idx++;
+    const char *table = preflop_path;
+    if (!table && access(PREFLOP_FILE, F_OK) == 0)
+        table = PREFLOP_FILE;
+    if (table) {
+        opts.preflop_table = table;
+        pa_context_t *with_table = pa_context_new(&opts, err, sizeof(err));
+        if (with_table) {
+            pa_context_free(ctx);
+            ctx = with_table;
         } else {
-            break;
+            printf("Warning: cannot use preflop table %s, simulating instead.\n\n", table);
         }
     }
-    if (num_community == 1 || num_community == 2) {
-        printf("Error: community cards must be 0 (pre-flop), 3 (flop), 4 (turn), or 5 (river).\n");
-        return 1;
+
+    if (batch_path) {
+        FILE *in = strcmp(batch_path, "-") == 0 ? stdin : fopen(batch_path, "r");
+        if (!in) {
+            printf("Error: cannot open %s.\n", batch_path);
+            pa_context_free(ctx);
+            return 1;
+        }
+        int pool = opts.threads;
+        if (!threads_given) {
+            long cores = sysconf(_SC_NPROCESSORS_ONLN);
+            pool = (cores < 1) ? 1 : (cores > PA_MAX_THREADS) ? PA_MAX_THREADS : (int)cores;
+        }
+        run_batch(in, stdout, ctx, seed, pool);
+        if (in != stdin) fclose(in);
+        pa_context_free(ctx);
+        return 0;
+    }
+
+    if (server || socket_path) {
+        int rc = 0;
+        if (socket_path) rc = serve_socket(socket_path, ctx, seed);
+        else serve_stream(stdin, stdout, ctx, seed);
+        pa_context_free(ctx);
+        return rc;
     }
-    /* Check for duplicate cards */
-    {
-        card_t all_cards[7];
-        int n = 0;
-        all_cards[n++] = hole[0]; all_cards[n++] = hole[1];
-        for (int i = 0; i < num_community; i++) all_cards[n++] = community[i];
-        for (int i = 0; i < n; i++)
-            for (int j = i+1; j < n; j++)
-                if (all_cards[i].face == all_cards[j].face && all_cards[i].suit == all_cards[j].suit) {
-                    printf("Error: duplicate card %s%c detected.\n",
-                        face_str(all_cards[i].face), suit_char(all_cards[i].suit));
-                    return 1;
-                }
+
+    pa_spot_t req;
+    if (!pa_spot_parse(argv + 1, argc - 1, &req, err, sizeof(err))) {
+        printf("Error: %s\n", err);
+        pa_context_free(ctx);
+        return 1;
     }
-    if (arg_idx < argc) pot = atoi(argv[arg_idx++]);
-    if (arg_idx < argc) to_call = atoi(argv[arg_idx++]);
 
     /* Print input */
-    printf("Hole cards: %s%c %s%c\n",
-        face_str(hole[0].face), suit_char(hole[0].suit),
-        face_str(hole[1].face), suit_char(hole[1].suit));
-    if (num_community > 0) {
+    char c0[4];
+    printf("Hole cards: ");
+    for (int i = 0; i < (req.game == PA_GAME_OMAHA ? 4 : 2); i++) {
+        pa_card_format(req.hole[i], c0);
+        printf("%s%s", i ? " " : "", c0);
+    }
+    printf("%s\n", req.game == PA_GAME_OMAHA ? " (Omaha)" : "");
+    if (req.num_community > 0) {
         printf("Community:  ");
-        for (int i = 0; i < num_community; i++)
-            printf("%s%c ", face_str(community[i].face), suit_char(community[i].suit));
+        for (int i = 0; i < req.num_community; i++) {
+            pa_card_format(req.community[i], c0);
+            printf("%s ", c0);
+        }
         printf("\n");
     }
-    printf("Pot: $%d  To call: $%d\n\n", pot, to_call);
+    if (req.range || range_spec)
+        printf("Opponent range: %s\n", req.range ? req.range : range_spec);
+    printf("Pot: $%d  To call: $%d\n\n", req.pot, req.to_call);
 
     /* Run simulation */
-    rank_t current_rank;
-    double win_pct = simulate(hole, community, num_community, &current_rank);
+    pa_answer_t ans;
+    pa_rng_t rng;
+    pa_rng_seed(&rng, seed);
+    bool ok = pa_advise(ctx, &req, &rng, &ans, err, sizeof(err));
+    pa_context_free(ctx);
+    if (!ok) {
+        printf("Error: %s\n", err);
+        return 1;
+    }
+
+    const pa_sim_t *sim = &ans.sim;
+    double win_pct = ans.win_pct;
+    printf("Current hand: %s\n", pa_rank_name(ans.current.rankVal));
+    if (sim->method == PA_TABLE) {
+        char name[4];
+        pa_hand_class(req.hole, name);
+        printf("Win probability: %.1f%% +/- %.1f%% (95%% CI, %ld simulations vs %d opponent%s)\n",
+            win_pct * 100.0, 1.96 * sim->std_error * 100.0, sim->outcomes, ans.opponents,
+            ans.opponents == 1 ? "" : "s");
+        printf("Method: preflop table lookup (%s)\n", name);
+    } else if (sim->method == PA_EXACT) {
+        printf("Win probability: %.1f%% (exact, %ld showdowns vs %d opponent%s)\n",
+            win_pct * 100.0, sim->outcomes, ans.opponents, ans.opponents == 1 ? "" : "s");
+        printf("Method: exact enumeration, %ld evaluations\n", sim->evaluations);
+    } else {
+        static const char *stop_names[] = {"done", "target reached", "sample cap", "time cap"};
+        printf("Win probability: %.1f%% +/- %.1f%% (95%% CI, %ld simulations vs %d opponent%s",
+            win_pct * 100.0, 1.96 * sim->std_error * 100.0, sim->outcomes, ans.opponents,
+            ans.opponents == 1 ? "" : "s");
+        if (opts.threads > 1 || seed_given)
+            printf(", %d thread%s, seed %llu", opts.threads, opts.threads == 1 ? "" : "s",
+                (unsigned long long)seed);
+        printf(")\n");
+        printf("Method: Monte Carlo, stopped at %s, %ld evaluations",
+            stop_names[sim->stop], sim->evaluations);
+        if (sim->dropped)
+            printf(", %ld deals dropped for shared range cards", sim->dropped);
+        if (sim->sampling == PA_SAMPLE_STRATIFIED)
+            printf(", stratified by runout (%.1fx less variance than plain)", sim->variance_reduction);
+        printf("\n");
+        if (sim->outcomes == 0)
+            printf("Warning: no deal fits the opponent ranges around the known cards.\n");
+    }
+    if (sim->hist_trials) {
+        static const char *street_names[] = {"flop", "", "", "turn", "river"};
+        printf("\nEquity once the %s is out: mean %.1f%%, std dev %.1f%% (%ld trials)\n",
+            street_names[req.num_community], sim->hist_mean * 100.0, sim->hist_sd * 100.0,
+            sim->hist_trials);
+        for (int b = 0; b < PA_EQUITY_BUCKETS; b++) {
+            double share = (double)sim->hist[b] / sim->hist_trials;
+            printf("  %3d-%3d%%  %5.1f%%  ", b * 100 / PA_EQUITY_BUCKETS, (b + 1) * 100 / PA_EQUITY_BUCKETS,
+                share * 100.0);
+            for (int k = 0; k < (int)(share * 50.0 + 0.5); k++) putchar('#');
+            printf("\n");
+        }
+    }
 
-    printf("Current hand: %s\n", (current_rank.rankVal < NUM_RANKS) ?
-        RANK_NAMES[current_rank.rankVal] : "N/A");
-    printf("Win probability: %.1f%% (%d simulations vs %d opponents)\n",
-        win_pct * 100.0, NUM_SIMULATIONS, NUM_OPPONENTS);
+    if (req.num_stacks) {
+        printf("\nPots: $%.1f expected back for $%d all in (net %+.1f)\n",
+            sim->chips, req.stacks[0], sim->chips - req.stacks[0]);
+    }
+
+    if (ans.outs.unseen) {
+        const pa_outs_t *o = &ans.outs;
+        printf("\nOuts: %d of %d unseen cards", o->outs, o->unseen);
+        for (int r = 0, n = 0; r < PA_NUM_RANKS; r++)
+            if (o->by_rank[r]) printf("%s%d to %s", n++ ? ", " : " (", o->by_rank[r], pa_rank_name(r));
+        printf("%s\n", o->outs ? ")" : "");
+        printf("Improves: %.1f%% on the next card, %.1f%% by the river\n",
+            o->improve_next * 100.0, o->improve_river * 100.0);
+    }
 
     /* Get recommendation */
-    advice_t advice = recommend(win_pct, pot, to_call, big_blind);
-    printf("\nHand strength: %s\n", advice.strength);
-    printf("Recommendation: %s", advice.action);
-    if (strcmp(advice.action, "RAISE") == 0)
-        printf(" $%d", advice.amount);
-    else if (strcmp(advice.action, "CALL") == 0)
-        printf(" $%d", to_call);
+    const pa_advice_t *advice = &ans.advice;
+    printf("\nHand strength: %s\n", advice->strength);
+    printf("Recommendation: %s", advice->action);
+    if (strcmp(advice->action, "RAISE") == 0)
+        printf(" $%d", advice->amount);
+    else if (strcmp(advice->action, "CALL") == 0)
+        printf(" $%d", req.to_call);
+    printf(" (EV %+.1f)\n", advice->ev);
+    printf("EV by action: %s %+.1f", req.to_call ? "call" : "check", advice->ev_call);
+    if (req.to_call) printf(", fold +0.0");
+    for (int i = 0; i < PA_NUM_RAISE_SIZES; i++)
+        if (advice->raise[i] > 0) printf(", raise $%d %+.1f", advice->raise[i], advice->ev_raise[i]);
     printf("\n");
 
     return 0;
@@ -0,0 +1,1200 @@
+/********************************************************************
+  Author: Vikas Yadav
+  Filename: poker_advisor_test.c
+  Copyright (c) 2017-2026 Vikas Yadav. All rights reserved.
+
+  Regression tests for libpokeradvisor, built from its source so they
+  can reach its internals as well as the pa_* API. Covers simulation
+  (sampled, exact, adaptive, stratified), action values, split and side
+  pots, Omaha, outs, the equity cache, opponent ranges, request and
+  batch parsing, and the library API from several threads. Last, it
+  walks every one of the 133,784,560 seven-card hands (and all 5- and
+  6-card ones) and checks that the table-driven best_hand() returns
+  exactly the rank the original 21-way rank_hand() loop produced, so
+  hand ordering is unchanged. Exits non-zero on any failure.
+
+  Build:  gcc -O2 -pthread -o poker_advisor_test poker_advisor_test.c -lm
+  Usage:  ./poker_advisor_test
+********************************************************************/
+#include "libpokeradvisor.c"
+
+/* Original 5-card evaluator, kept verbatim as the reference */
+static rank_t rank_hand(card_t hand[5])
+{
+    rank_t r = {9, -1, -1, -1};
+    int faces[5], suits[5];
+    int i, j;
+
+    /* Sort by face */
+    for (i = 0; i < 5; i++) { faces[i] = hand[i].face; suits[i] = hand[i].suit; }
+    for (i = 0; i < 4; i++)
+        for (j = i+1; j < 5; j++)
+            if (faces[j] < faces[i]) {
+                int tf = faces[i]; faces[i] = faces[j]; faces[j] = tf;
+                int ts = suits[i]; suits[i] = suits[j]; suits[j] = ts;
+            }
+
+    bool is_flush = (suits[0]==suits[1] && suits[1]==suits[2] && suits[2]==suits[3] && suits[3]==suits[4]);
+
+    bool is_straight = false;
+    int straight_high = -1;
+    bool consec = true;
+    for (i = 1; i < 5; i++) if (faces[i] != faces[i-1]+1) { consec = false; break; }
+    if (consec) { is_straight = true; straight_high = faces[4]; }
+    /* Wheel: A-2-3-4-5 */
+    if (!is_straight && faces[0]==0 && faces[1]==1 && faces[2]==2 && faces[3]==3 && faces[4]==12) {
+        is_straight = true; straight_high = 3;
+    }
+
+    /* Count face occurrences */
+    int counts[13] = {0};
+    for (i = 0; i < 5; i++) counts[faces[i]]++;
+
+    typedef struct { int face, count; } group_t;
+    group_t groups[5];
+    int ng = 0;
+    for (i = 0; i < 13; i++) if (counts[i]) { groups[ng].face = i; groups[ng].count = counts[i]; ng++; }
+    /* Sort groups: by count desc, then face desc */
+    for (i = 0; i < ng-1; i++)
+        for (j = i+1; j < ng; j++)
+            if (groups[j].count > groups[i].count ||
+                (groups[j].count == groups[i].count && groups[j].face > groups[i].face)) {
+                group_t tmp = groups[i]; groups[i] = groups[j]; groups[j] = tmp;
+            }
+
+    if (is_straight && is_flush) {
+        r.rankVal = (straight_high == 12) ? 0 : 1;
+        r.high = straight_high;
+        return r;
+    }
+    if (groups[0].count == 4) {
+        r.rankVal = 2; r.high = groups[0].face; r.kicker = groups[1].face; return r;
+    }
+    if (groups[0].count == 3 && ng > 1 && groups[1].count == 2) {
+        r.rankVal = 3; r.high = groups[0].face; r.high2 = groups[1].face; r.kicker = groups[1].face; return r;
+    }
+    if (is_flush) {
+        r.rankVal = 4; r.high = faces[4]; r.kicker = faces[3]; return r;
+    }
+    if (is_straight) {
+        r.rankVal = 5; r.high = straight_high; return r;
+    }
+    if (groups[0].count == 3) {
+        r.rankVal = 6; r.high = groups[0].face;
+        r.kicker = (ng > 1) ? groups[1].face : -1;
+        return r;
+    }
+    if (groups[0].count == 2 && ng > 1 && groups[1].count == 2) {
+        int hp = groups[0].face > groups[1].face ? groups[0].face : groups[1].face;
+        int lp = groups[0].face < groups[1].face ? groups[0].face : groups[1].face;
+        r.rankVal = 7; r.high = hp; r.high2 = lp;
+        r.kicker = (ng > 2) ? groups[2].face : -1;
+        return r;
+    }
+    if (groups[0].count == 2) {
+        r.rankVal = 8; r.high = groups[0].face;
+        int best_k = -1;
+        for (i = 1; i < ng; i++) if (groups[i].face > best_k) best_k = groups[i].face;
+        r.kicker = best_k;
+        return r;
+    }
+    r.rankVal = 9; r.high = faces[4]; r.high2 = faces[3]; r.kicker = faces[2];
+    return r;
+}
+
+/* Original compare_ranks(), kept verbatim as the reference */
+static int compare_ranks_ref(rank_t *a, rank_t *b)
+{
+    if (a->rankVal != b->rankVal) return a->rankVal < b->rankVal ? 1 : -1;
+    if (a->high != b->high) return a->high > b->high ? 1 : -1;
+    if (a->high2 != b->high2) return a->high2 > b->high2 ? 1 : -1;
+    if (a->kicker != b->kicker) return a->kicker > b->kicker ? 1 : -1;
+    return 0;
+}
+
+/*
+ * rank_hand() of every 5-card subset of the deck, indexed by the subset's
+ * combinatorial number, so the reference 21-way loop below costs lookups
+ * instead of 21 sorts per 7-card hand.
+ */
+static int     binom[DECK_SIZE+1][6];
+static rank_t *ref5;
+
+static int combo_index(const int idx[5])
+{
+    return binom[idx[0]][1] + binom[idx[1]][2] + binom[idx[2]][3] +
+           binom[idx[3]][4] + binom[idx[4]][5];
+}
+
+static void build_ref5(const card_t deck[DECK_SIZE])
+{
+    int idx[5];
+
+    for (int n = 0; n <= DECK_SIZE; n++) {
+        binom[n][0] = 1;
+        for (int k = 1; k < 6; k++)
+            binom[n][k] = (n == 0) ? 0 : binom[n-1][k-1] + binom[n-1][k];
+    }
+    ref5 = malloc(sizeof(rank_t) * binom[DECK_SIZE][5]);
+    for (idx[0] = 0; idx[0] < DECK_SIZE; idx[0]++)
+    for (idx[1] = idx[0]+1; idx[1] < DECK_SIZE; idx[1]++)
+    for (idx[2] = idx[1]+1; idx[2] < DECK_SIZE; idx[2]++)
+    for (idx[3] = idx[2]+1; idx[3] < DECK_SIZE; idx[3]++)
+    for (idx[4] = idx[3]+1; idx[4] < DECK_SIZE; idx[4]++) {
+        card_t hand5[5] = {deck[idx[0]], deck[idx[1]], deck[idx[2]], deck[idx[3]], deck[idx[4]]};
+        ref5[combo_index(idx)] = rank_hand(hand5);
+    }
+}
+
+/* Original best-5-of-N loop over rank_hand(), on deck positions */
+static rank_t best_hand_ref(const int *pos, int n)
+{
+    rank_t best = {10, -1, -1, -1};
+    int a, b, c, d, e;
+
+    for (a = 0; a < n-4; a++)
+    for (b = a+1; b < n-3; b++)
+    for (c = b+1; c < n-2; c++)
+    for (d = c+1; d < n-1; d++)
+    for (e = d+1; e < n; e++) {
+        int idx5[5] = {pos[a], pos[b], pos[c], pos[d], pos[e]};
+        rank_t *r = &ref5[combo_index(idx5)];
+        if (compare_ranks_ref(r, &best) > 0)
+            best = *r;
+    }
+    return best;
+}
+
+static bool same_rank(rank_t a, rank_t b)
+{
+    return a.rankVal == b.rankVal && a.high == b.high &&
+           a.high2 == b.high2 && a.kicker == b.kicker;
+}
+
+static void print_cards(card_t *cards, int n)
+{
+    for (int i = 0; i < n; i++)
+        printf("%s%c ", face_str(cards[i].face), suit_char(cards[i].suit));
+}
+
+/* Every 5, 6 and 7 card hand: table rank must equal the reference rank */
+static int test_all_hands(const card_t deck[DECK_SIZE], int n)
+{
+    card_t cards[7];
+    int idx[7];
+    long checked = 0, failed = 0;
+    rank_t prev_got = {10, -1, -1, -1}, prev_want = {10, -1, -1, -1};
+
+    for (int i = 0; i < n; i++) idx[i] = i;
+
+    for (;;) {
+        for (int i = 0; i < n; i++) cards[i] = deck[idx[i]];
+        rank_t got = best_hand(cards_mask(cards, n));
+        rank_t want = best_hand_ref(idx, n);
+        if (!same_rank(got, want)) {
+            if (failed++ < 10) {
+                printf("  MISMATCH ");
+                print_cards(cards, n);
+                printf(": got {%d,%d,%d,%d} want {%d,%d,%d,%d}\n",
+                    got.rankVal, got.high, got.high2, got.kicker,
+                    want.rankVal, want.high, want.high2, want.kicker);
+            }
+        }
+        /* compare_ranks() must order neighbours exactly as before */
+        if (compare_ranks(&got, &prev_got) != compare_ranks_ref(&want, &prev_want))
+            failed++;
+        prev_got = got;
+        prev_want = want;
+        checked++;
+
+        /* Next combination in lexicographic order */
+        int k = n - 1;
+        while (k >= 0 && idx[k] == DECK_SIZE - n + k) k--;
+        if (k < 0) break;
+        idx[k]++;
+        for (int i = k+1; i < n; i++) idx[i] = idx[i-1] + 1;
+    }
+
+    printf("TEST %d-card hands: %ld checked, %ld mismatches -> %s\n",
+        n, checked, failed, failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/* Ordering spot checks across categories */
+static int test_ordering(void)
+{
+    static const char *ladder[][7] = {
+        {"Ah","Kh","Qh","Jh","Th","2c","3d"},   /* Royal Flush */
+        {"9s","8s","7s","6s","5s","Ah","Ad"},   /* Straight Flush */
+        {"5c","4c","3c","2c","Ac","Ks","Kd"},   /* Straight Flush (wheel) */
+        {"Qs","Qh","Qd","Qc","2h","3s","4d"},   /* Four of a Kind */
+        {"Kh","Ks","Kd","2c","2d","7h","9s"},   /* Full House */
+        {"Ah","9h","7h","4h","2h","Ks","Kd"},   /* Flush */
+        {"Td","9c","8h","7s","6d","2c","2h"},   /* Straight */
+        {"5d","4c","3h","2s","Ad","Kc","Kh"},   /* Straight (wheel) */
+        {"7h","7s","7d","Ac","Kd","2h","4s"},   /* Three of a Kind */
+        {"Jh","Js","4d","4c","Ah","8s","2d"},   /* Two Pair */
+        {"Th","Ts","Ad","Kc","8h","6s","2d"},   /* One Pair */
+        {"Ah","Qs","Td","8c","6h","4s","2d"},   /* High Card */
+    };
+    int n = (int)(sizeof(ladder) / sizeof(ladder[0]));
+    int failed = 0;
+    hand_val_t prev = 0;
+
+    for (int i = 0; i < n; i++) {
+        card_t cards[7];
+        for (int j = 0; j < 7; j++) parse_card(ladder[i][j], &cards[j]);
+        hand_val_t v = eval_mask(cards_mask(cards, 7));
+        if (i > 0 && v >= prev) {
+            printf("  ORDER ");
+            print_cards(cards, 7);
+            printf("should rank below the hand before it\n");
+            failed++;
+        }
+        prev = v;
+    }
+    printf("TEST category ordering: %d hands -> %s\n", n, failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/* A made royal flush on the river can only win; advice must be to raise */
+static int test_simulate(void)
+{
+    const char *names[7] = {"Ah","Kh","Qh","Jh","Th","2c","3d"};
+    card_t cards[7];
+    rank_t current;
+    sim_result_t res;
+    sim_opts_t opts = sim_opts_default();
+    int failed = 0;
+
+    for (int i = 0; i < 7; i++) parse_card(names[i], &cards[i]);
+    double win_pct = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 5), &current, &opts, &res);
+    advice_t advice = recommend(res.eq_vs, opts.opponents, 100, 20, 20, INT_MAX);
+    if (win_pct != 1.0 || current.rankVal != 0 || strcmp(advice.action, "RAISE") != 0) {
+        printf("  got %.3f, %s, %s\n", win_pct, RANK_NAMES[current.rankVal], advice.action);
+        failed++;
+    }
+    printf("TEST simulate on a made royal flush -> %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Action values: pot odds, a bluff that breaks even, and raising for value */
+static int test_action_values(void)
+{
+    double weak[3] = {1.0, 0.10, 0.01}, even[2] = {1.0, 0.0}, strong[3] = {1.0, 0.90, 0.81};
+    int failed = 0;
+
+    /* 10% against 50 to win 150 is a fold; checking is free */
+    advice_t a = recommend(weak, 2, 100, 50, 20, INT_MAX);
+    advice_t b = recommend(weak, 2, 100, 0, 20, INT_MAX);
+    if (strcmp(a.action, "FOLD") != 0 || a.ev != 0.0 || fabs(a.ev_call - (0.01 * 150 - 50)) > 1e-9 ||
+        strcmp(b.action, "CHECK") != 0) {
+        printf("  weak: %s (call %.2f), unbet %s\n", a.action, a.ev_call, b.action);
+        failed++;
+    }
+
+    /* Folding r / (P + r) of the time makes a pure bluff worth nothing */
+    a = recommend(even, 1, 100, 0, 20, INT_MAX);
+    for (int i = 0; i < NUM_RAISE_SIZES; i++)
+        if (fabs(a.ev_raise[i]) > 1e-9) {
+            printf("  bluff of %d: EV %.4f\n", a.raise[i], a.ev_raise[i]);
+            failed++;
+        }
+    if (strcmp(a.action, "CHECK") != 0) {
+        printf("  zero equity: %s\n", a.action);
+        failed++;
+    }
+
+    /* A strong hand raises, never under the bet faced */
+    a = recommend(strong, 2, 60, 40, 20, INT_MAX);
+    if (strcmp(a.action, "RAISE") != 0 || a.amount < 40 || a.ev <= a.ev_call) {
+        printf("  strong: %s %d, EV %.2f vs call %.2f\n", a.action, a.amount, a.ev, a.ev_call);
+        failed++;
+    }
+    for (int i = 0; i < NUM_RAISE_SIZES; i++)
+        if (a.raise[i] < 40) {
+            printf("  raise of %d under the bet of 40\n", a.raise[i]);
+            failed++;
+        }
+
+    /* Stacks: raises stop at the effective stack, and all in there is none */
+    a = recommend(strong, 2, 60, 40, 20, 30);
+    for (int i = 0; i < NUM_RAISE_SIZES; i++)
+        if (a.raise[i] > 30) {
+            printf("  raise of %d over a stack that leaves 30\n", a.raise[i]);
+            failed++;
+        }
+    a = recommend(strong, 2, 60, 40, 20, 0);
+    if (strcmp(a.action, "CALL") != 0 || a.amount != 40) {
+        printf("  all in: %s %d\n", a.action, a.amount);
+        failed++;
+    }
+    printf("TEST expected-value actions -> %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/* Same (seed, threads) must reproduce the same equity bit for bit */
+static int test_determinism(void)
+{
+    const char *names[5] = {"Ah","Kh","Qh","Jh","2c"};
+    card_t cards[5];
+    rank_t current;
+    int failed = 0;
+
+    for (int i = 0; i < 5; i++) parse_card(names[i], &cards[i]);
+    for (int threads = 1; threads <= 4; threads++) {
+        sim_opts_t opts = sim_opts_default();
+        opts.threads = threads;
+        opts.seed = 12345;
+        double a = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 3), &current, &opts, NULL);
+        double b = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 3), &current, &opts, NULL);
+        if (a != b) {
+            printf("  %d threads: %.6f then %.6f\n", threads, a, b);
+            failed++;
+        }
+    }
+    printf("TEST simulate determinism per (seed, threads) -> %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* River enumeration must visit every showdown once and agree with sampling */
+static int test_exact(void)
+{
+    const char *names[7] = {"Ah","Kh","Qh","Jh","2c","7d","9s"};
+    card_t cards[7];
+    rank_t current;
+    sim_result_t exact_res, mc_res;
+    sim_opts_t exact_opts = sim_opts_default();
+    sim_opts_t mc_opts = sim_opts_default();
+    int failed = 0;
+
+    exact_opts.exact_budget = 2e8;
+    exact_opts.threads = 2;
+    mc_opts.exact_budget = 0;
+    mc_opts.trials = 200000;
+    mc_opts.target_se = 0;
+    mc_opts.seed = 7;
+    for (int i = 0; i < 7; i++) parse_card(names[i], &cards[i]);
+    double exact = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 5), &current, &exact_opts, &exact_res);
+    double mc = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 5), &current, &mc_opts, &mc_res);
+    double expected = exact_outcome_count(45, 5, DEFAULT_OPPONENTS, 2);
+
+    if (exact_res.method != PA_EXACT || mc_res.method != PA_MONTE_CARLO ||
+        exact_res.outcomes != (long)(expected + 0.5) || exact_res.evaluations != 991 ||
+        mc - exact > 0.005 || exact - mc > 0.005) {
+        printf("  exact %.4f (%ld showdowns, %ld evals), mc %.4f\n",
+            exact, exact_res.outcomes, exact_res.evaluations, mc);
+        failed++;
+    }
+    /* Equity against fewer opponents: counted subsets vs sampled prefixes */
+    for (int k = 1; k <= DEFAULT_OPPONENTS; k++) {
+        double e = exact_res.eq_vs[k], m = mc_res.eq_vs[k];
+        if (e - m > 0.005 || m - e > 0.005 || (k > 1 && e > exact_res.eq_vs[k-1])) {
+            printf("  against %d: exact %.4f, mc %.4f\n", k, e, m);
+            failed++;
+        }
+    }
+    if (fabs(exact_res.eq_vs[DEFAULT_OPPONENTS] - exact) > 1e-12 ||
+        fabs(mc_res.eq_vs[DEFAULT_OPPONENTS] - mc) > 1e-12) {
+        printf("  against all: %.6f vs %.6f, %.6f vs %.6f\n",
+            exact_res.eq_vs[DEFAULT_OPPONENTS], exact, mc_res.eq_vs[DEFAULT_OPPONENTS], mc);
+        failed++;
+    }
+    printf("TEST exact river enumeration -> %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Adaptive stopping: lopsided spots stop early, a coin flip runs to the cap */
+static int test_adaptive(void)
+{
+    const char *lopsided[5] = {"Ah","Ad","As","Ac","2d"};   /* quad aces on the flop */
+    const char *flip[2] = {"7h","6h"};
+    card_t cards[5];
+    rank_t current;
+    sim_result_t res;
+    sim_opts_t opts = sim_opts_default();
+    int failed = 0;
+
+    opts.seed = 99;
+    for (int i = 0; i < 5; i++) parse_card(lopsided[i], &cards[i]);
+    simulate(cards_mask(cards, 2), cards_mask(cards + 2, 3), &current, &opts, &res);
+    if (res.stop != PA_STOP_TARGET || res.outcomes >= opts.trials || res.std_error > opts.target_se) {
+        printf("  lopsided: %ld samples, se %.4f\n", res.outcomes, res.std_error);
+        failed++;
+    }
+
+    opts.target_se = 0.001;
+    opts.trials = 4000;
+    for (int i = 0; i < 2; i++) parse_card(flip[i], &cards[i]);
+    simulate(cards_mask(cards, 2), cards_mask(cards + 2, 0), &current, &opts, &res);
+    if (res.stop != PA_STOP_SAMPLES || res.outcomes != opts.trials) {
+        printf("  capped: %ld samples, stop %d\n", res.outcomes, res.stop);
+        failed++;
+    }
+    printf("TEST adaptive stopping -> %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Every table size 1..9 shares one board per trial; equity falls as seats fill */
+static int test_opponents(void)
+{
+    const char *names[5] = {"Ah","Ad","7c","8d","9s"};
+    card_t cards[5];
+    rank_t current;
+    sim_result_t res;
+    double prev = 1.0;
+    int failed = 0;
+
+    for (int i = 0; i < 5; i++) parse_card(names[i], &cards[i]);
+    for (int opp = 1; opp <= MAX_OPPONENTS; opp++) {
+        sim_opts_t opts = sim_opts_default();
+        opts.opponents = opp;
+        opts.exact_budget = 0;
+        opts.seed = 11;
+        double eq = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 3), &current, &opts, &res);
+        if (eq >= prev || res.evaluations > res.outcomes * (1 + opp)) {
+            printf("  %d opponents: %.4f after %.4f, %ld evaluations for %ld trials\n",
+                opp, eq, prev, res.evaluations, res.outcomes);
+            failed++;
+        }
+        prev = eq;
+    }
+    printf("TEST opponent counts 1..%d -> %s\n", MAX_OPPONENTS, failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/*
+ * A flush draw's equity once the turn is out splits into made flushes and
+ * misses; a made royal flush never moves; the river has no next street.
+ */
+static int test_histogram(void)
+{
+    const char *names[7] = {"Ah","Kh","Qh","Jh","2c","Th","3d"};
+    card_t cards[7];
+    rank_t current;
+    sim_result_t res;
+    sim_opts_t opts = sim_opts_default();
+    int failed = 0;
+
+    for (int i = 0; i < 7; i++) parse_card(names[i], &cards[i]);
+    opts.opponents = 1;
+    opts.seed = 5;
+    opts.target_se = 0;
+    opts.hist_samples = 40;
+    double eq = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 3), &current, &opts, &res);
+    long sum = 0;
+    for (int b = 0; b < EQUITY_BUCKETS; b++) sum += res.hist[b];
+    if (res.method != PA_MONTE_CARLO || res.hist_trials != res.outcomes || sum != res.hist_trials ||
+        fabs(res.hist_mean - eq) > 0.02 || res.hist_sd < 0.15 ||
+        res.hist[EQUITY_BUCKETS-1] < res.hist_trials / 5) {
+        printf("  flush draw: %ld of %ld trials, mean %.4f vs %.4f, sd %.4f\n",
+            sum, res.hist_trials, res.hist_mean, eq, res.hist_sd);
+        failed++;
+    }
+
+    eq = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 4), &current, &opts, &res);
+    if (eq != 1.0 || res.hist[EQUITY_BUCKETS-1] != res.hist_trials || res.hist_sd != 0.0) {
+        printf("  royal flush: %.4f, %ld of %ld trials on top, sd %.4f\n",
+            eq, res.hist[EQUITY_BUCKETS-1], res.hist_trials, res.hist_sd);
+        failed++;
+    }
+
+    simulate(cards_mask(cards, 2), cards_mask(cards + 2, 5), &current, &opts, &res);
+    if (res.hist_trials != 0) {
+        printf("  river: %ld histogram trials\n", res.hist_trials);
+        failed++;
+    }
+    printf("TEST next-street equity histogram -> %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/*
+ * Stratified sampling: unbiased against exact enumeration, less variance
+ * on a drawing flop, the same answer per (seed, threads), and plain
+ * sampling where there is no board to stratify
+ */
+static int test_stratified(void)
+{
+    const char *names[6] = {"Ah","Kh","Qh","Jh","2c","9s"};
+    card_t cards[6];
+    rank_t current;
+    sim_result_t res, again;
+    sim_opts_t opts = sim_opts_default();
+    int failed = 0;
+
+    for (int i = 0; i < 6; i++) parse_card(names[i], &cards[i]);
+    cardmask_t hole = cards_mask(cards, 2), flop = cards_mask(cards + 2, 3);
+    opts.opponents = 1;
+    opts.exact_budget = 2e6;
+    double exact = simulate(hole, flop, &current, &opts, NULL);
+
+    opts.exact_budget = 0;
+    opts.target_se = 0;
+    opts.trials = 50000;
+    opts.seed = 9;
+    opts.stratified = true;
+    double eq = simulate(hole, flop, &current, &opts, &res);
+    if (res.sampling != PA_SAMPLE_STRATIFIED || fabs(eq - exact) > 4 * res.std_error ||
+        res.variance_reduction < 1.2) {
+        printf("  heads-up flop: %.4f +/- %.4f vs exact %.4f, reduction %.2f\n",
+            eq, res.std_error, exact, res.variance_reduction);
+        failed++;
+    }
+
+    opts.opponents = 6;
+    opts.threads = 3;
+    eq = simulate(hole, flop, &current, &opts, &res);
+    double eq2 = simulate(hole, flop, &current, &opts, &again);
+    if (eq != eq2 || res.variance_reduction < 2.5 || res.outcomes != opts.trials) {
+        printf("  6 opponents, 3 threads: %.6f then %.6f, reduction %.2f\n",
+            eq, eq2, res.variance_reduction);
+        failed++;
+    }
+
+    opts.threads = 1;
+    simulate(hole, flop | cards_mask(cards + 5, 1) | 1ULL << 51, &current, &opts, &res);
+    if (res.sampling != PA_SAMPLE_PLAIN || res.variance_reduction != 1.0) {
+        printf("  river spot sampled %d, reduction %.2f\n", res.sampling, res.variance_reduction);
+        failed++;
+    }
+    printf("TEST stratified sampling -> %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/*
+ * The game's side pots, one deal at a time: pots by contribution level,
+ * each split evenly among the best hands of the players in it
+ */
+static double reference_pots(const int *stacks, int players, int dead, const hand_val_t *val)
+{
+    double won = 0.0;
+    int prev = 0;
+    for (;;) {
+        int level = 0;
+        for (int i = 0; i < players; i++)
+            if (stacks[i] > prev && (level == 0 || stacks[i] < level)) level = stacks[i];
+        if (level == 0) return won;
+        double amount = prev ? 0 : dead;
+        hand_val_t top = 0;
+        int winners = 0;
+        for (int i = 0; i < players; i++) {
+            if (stacks[i] <= prev) continue;
+            amount += (stacks[i] < level ? stacks[i] : level) - prev;
+            if (stacks[i] < level) continue;
+            if (val[i] > top) { top = val[i]; winners = 0; }
+            winners += val[i] == top;
+        }
+        if (val[0] == top && stacks[0] >= level) won += amount / winners;
+        prev = level;
+    }
+}
+
+/* Pot shares: exact splits among tied players, and side pots by stack */
+static int test_side_pots(void)
+{
+    const char *chop[7] = {"2c","3d","Ah","Kh","Qh","Jh","Th"};   /* the board plays */
+    const char *spot[7] = {"Ah","Qd","Kc","Kd","7s","7h","2c"};
+    const int chop_stacks[3] = {300, 100, 100};
+    const int stacks[4] = {500, 100, 300, 800};
+    card_t cards[7];
+    rank_t current;
+    sim_result_t res;
+    sim_opts_t opts = sim_opts_default();
+    int failed = 0;
+
+    /* Three ways split three ways, exact or sampled; the hero's 200 uncalled come back */
+    for (int i = 0; i < 7; i++) parse_card(chop[i], &cards[i]);
+    opts.opponents = 2;
+    opts.stacks = chop_stacks;
+    opts.pot = 30;
+    for (int exact = 1; exact >= 0; exact--) {
+        opts.exact_budget = exact ? EXACT_BUDGET : 0;
+        opts.trials = 2000;
+        double eq = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 5), &current, &opts, &res);
+        if (res.method != (exact ? PA_EXACT : PA_MONTE_CARLO) || fabs(eq - 1.0 / 3) > 1e-12 ||
+            fabs(res.eq_vs[1] - 0.5) > 1e-12 || fabs(res.chips - 310.0) > 1e-9) {
+            printf("  chop (%s): equity %.6f, against one %.6f, chips %.3f\n",
+                exact ? "exact" : "sampled", eq, res.eq_vs[1], res.chips);
+            failed++;
+        }
+    }
+
+    /* Four stacks, three pots, against the game's rules dealt directly */
+    for (int i = 0; i < 7; i++) parse_card(spot[i], &cards[i]);
+    cardmask_t hole = cards_mask(cards, 2), board = cards_mask(cards + 2, 5);
+    opts = sim_opts_default();
+    opts.opponents = 3;
+    opts.stacks = stacks;
+    opts.pot = 60;
+    opts.exact_budget = 0;
+    opts.target_se = 0;
+    opts.trials = 200000;
+    opts.seed = 5;
+    simulate(hole, board, &current, &opts, &res);
+
+    rng_t rng;
+    double sum = 0.0, sq = 0.0;
+    const int deals = 200000;
+    rng_seed(&rng, 6);
+    for (int d = 0; d < deals; d++) {
+        cardmask_t used = hole | board;
+        hand_val_t val[4] = {eval7(hole | board)};
+        for (int o = 1; o <= 3; o++) {
+            cardmask_t h = 0;
+            while (mask_count(h) < 2) {
+                cardmask_t c = 1ULL << rng_bounded(&rng, DECK_SIZE);
+                if (!(c & used)) { h |= c; used |= c; }
+            }
+            val[o] = eval7(h | board);
+        }
+        double won = reference_pots(stacks, 4, opts.pot, val);
+        sum += won;
+        sq += won * won;
+    }
+    double mean = sum / deals, se = sqrt((sq / deals - mean * mean) / deals);
+    if (fabs(res.chips - mean) > 4.0 * sqrt(2.0) * se) {
+        printf("  side pots: simulate %.2f, dealt directly %.2f +/- %.2f\n", res.chips, mean, se);
+        failed++;
+    }
+    printf("TEST split and side pots (%.1f chips vs %.1f) -> %s\n", res.chips, mean, failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Omaha: the prepared board against every two-plus-three hand, then equity and requests */
+static int test_omaha(void)
+{
+    const char *names[9] = {"Ah","Kh","Qd","Jd","Qh","Jh","2c","7s","3d"};
+    card_t cards[9];
+    rank_t current;
+    sim_result_t res;
+    sim_opts_t opts = sim_opts_default();
+    long checked = 0;
+    int failed = 0;
+    rng_t rng;
+
+    /* 4 hole cards on boards of 5, 4 and 3, the board prepared once per 8 holdings */
+    rng_seed(&rng, 25);
+    for (int deal = 0; deal < 30000; deal++) {
+        int num_board = 3 + deal % 3;
+        cardmask_t board = 0;
+        while (mask_count(board) < num_board) board |= 1ULL << rng_bounded(&rng, DECK_SIZE);
+        omaha_board_t ob;
+        omaha_prepare(&ob, board);
+        for (int h = 0; h < 8; h++) {
+            cardmask_t hole = 0;
+            while (mask_count(hole) < 4) {
+                cardmask_t c = 1ULL << rng_bounded(&rng, DECK_SIZE);
+                if (!(c & board)) hole |= c;
+            }
+            hand_val_t want = 0;
+            for (cardmask_t a = hole; a; a &= a - 1)
+                for (cardmask_t b = a & (a - 1); b; b &= b - 1)
+                    for (cardmask_t c = board; c; c &= c - 1)
+                        for (cardmask_t d = c & (c - 1); d; d &= d - 1)
+                            for (cardmask_t e = d & (d - 1); e; e &= e - 1) {
+                                hand_val_t v = eval_mask((a & -a) | (b & -b) | (c & -c) | (d & -d) | (e & -e));
+                                if (v > want) want = v;
+                            }
+            hand_val_t got = omaha_finish(&ob, hole);
+            rank_t r = omaha_best_hand(hole, board), g = val_to_rank(got);
+            if (got != want || compare_ranks(&r, &g) != 0) {
+                if (failed < 5)
+                    printf("  hole %016llx board %016llx: %u, want %u\n",
+                        (unsigned long long)hole, (unsigned long long)board, got, want);
+                failed++;
+            }
+            checked++;
+        }
+    }
+
+    /* The river enumerated exactly and sampled agree */
+    for (int i = 0; i < 9; i++) parse_card(names[i], &cards[i]);
+    cardmask_t hole = cards_mask(cards, 4), board = cards_mask(cards + 4, 5);
+    opts.omaha = true;
+    opts.opponents = 1;
+    double exact = simulate(hole, board, &current, &opts, &res);
+    if (res.method != PA_EXACT || res.outcomes != 123410 || current.rankVal != 7) {
+        printf("  exact: method %d, %ld showdowns, %s\n", res.method, res.outcomes, RANK_NAMES[current.rankVal]);
+        failed++;
+    }
+    opts.exact_budget = 0;
+    opts.target_se = 0;
+    opts.trials = 100000;
+    opts.seed = 3;
+    double sampled = simulate(hole, board, &current, &opts, &res);
+    if (fabs(sampled - exact) > 4.0 * res.std_error) {
+        printf("  river: exact %.4f, sampled %.4f +/- %.4f\n", exact, sampled, res.std_error);
+        failed++;
+    }
+
+    /* Requests: game=omaha takes four hole cards; ranges are hold'em only */
+    char line[] = "Ah Kh Qd Jd Qh Jh 2c 150 40 game=omaha opponents=2 seed=9", *tok[16];
+    char ranged[] = "Ah Kh Qd Jd 150 40 game=omaha range=QQ+";
+    char err[128];
+    pa_config_t cfg;
+    pa_config_default(&cfg);
+    pa_context_t *ctx = pa_context_new(&cfg, err, sizeof(err));
+    pa_spot_t spot;
+    pa_answer_t ans;
+    pa_rng_t prng;
+    int ntok = 0;
+    pa_rng_seed(&prng, 1);
+    for (char *t = strtok(line, " "); t; t = strtok(NULL, " ")) tok[ntok++] = t;
+    if (!pa_spot_parse(tok, ntok, &spot, err, sizeof(err)) || spot.game != PA_GAME_OMAHA ||
+        spot.num_community != 3 || spot.pot != 150 ||
+        !pa_advise(ctx, &spot, &prng, &ans, err, sizeof(err)) || ans.current.rankVal != 7 ||
+        ans.outs.unseen != 45) {
+        printf("  game=omaha request: %s\n", err);
+        failed++;
+    }
+    ntok = 0;
+    for (char *t = strtok(ranged, " "); t; t = strtok(NULL, " ")) tok[ntok++] = t;
+    if (!pa_spot_parse(tok, ntok, &spot, err, sizeof(err)) || pa_advise(ctx, &spot, &prng, &ans, err, sizeof(err))) {
+        printf("  an Omaha spot with a range was answered\n");
+        failed++;
+    }
+    pa_context_free(ctx);
+
+    printf("TEST Omaha (%ld hands, river %.4f exact vs %.4f sampled) -> %s\n",
+        checked, exact, sampled, failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Outs: pocket pair on a dry flop, and board pairs that are not outs */
+static int test_outs(void)
+{
+    const char *names[7] = {"8c","8d","Kh","7s","2d","Ah","Kd"};
+    card_t cards[7];
+    outs_t o;
+    int failed = 0;
+
+    for (int i = 0; i < 7; i++) parse_card(names[i], &cards[i]);
+    /* Two eights make a set; kings, sevens and deuces only pair the board */
+    count_outs(cards_mask(cards, 2), cards_mask(cards + 2, 3), false, &o);
+    if (o.unseen != 47 || o.outs != 2 || o.by_rank[6] != 2 ||
+        o.by_rank[7] != 0 || fabs(o.improve_next - 2.0 / 47) > 1e-12 ||
+        o.improve_river < o.improve_next || o.improve_river > 0.5) {
+        printf("  88 on Kh7s2d: %d of %d outs, next %.4f, river %.4f\n",
+            o.outs, o.unseen, o.improve_next, o.improve_river);
+        failed++;
+    }
+
+    /* A7 on the same flop: a seven pairs the board but makes trips with the hole seven */
+    card_t a7[2];
+    parse_card("Ac", &a7[0]);
+    parse_card("7h", &a7[1]);
+    count_outs(cards_mask(a7, 2), cards_mask(cards + 2, 3), false, &o);
+    if (o.outs != 5 || o.by_rank[6] != 2 || o.by_rank[7] != 3) {
+        printf("  A7 on Kh7s2d: %d outs, %d to trips, %d to two pair\n", o.outs, o.by_rank[6], o.by_rank[7]);
+        failed++;
+    }
+
+    /* On the turn the only card left decides both */
+    count_outs(cards_mask(cards, 2), cards_mask(cards + 2, 4), false, &o);
+    if (o.unseen != 46 || o.improve_river != o.improve_next) {
+        printf("  88 on Kh7s2dAh: next %.4f, river %.4f\n", o.improve_next, o.improve_river);
+        failed++;
+    }
+
+    /* Ah Kd on 7c 7d 2s: six aces and kings; a seven or deuce helps the board, not the hero */
+    const char *paired[3] = {"7c","7d","2s"};
+    for (int i = 0; i < 3; i++) parse_card(paired[i], &cards[2 + i]);
+    count_outs(cards_mask(cards + 5, 2), cards_mask(cards + 2, 3), false, &o);
+    if (o.outs != 6 || o.by_rank[7] != 6) {
+        printf("  AK on 7c7d2s: %d outs, %d to two pair\n", o.outs, o.by_rank[7]);
+        failed++;
+    }
+
+    count_outs(cards_mask(cards, 2), 0, false, &o);
+    if (o.unseen != 0 || o.outs != 0) {
+        printf("  preflop: %d outs\n", o.outs);
+        failed++;
+    }
+    printf("TEST outs and improvement odds -> %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/* 1326 hole combos fall into 169 classes: 6 per pair, 4 suited, 12 offsuit */
+static int test_preflop_classes(void)
+{
+    int combos[PREFLOP_CLASSES] = {0};
+    int failed = 0;
+
+    for (int a = 0; a < DECK_SIZE; a++)
+        for (int b = a+1; b < DECK_SIZE; b++) {
+            card_t hole[2] = {{a % 13, a / 13}, {b % 13, b / 13}};
+            combos[preflop_class(hole[0], hole[1])]++;
+        }
+    for (int cls = 0; cls < PREFLOP_CLASSES; cls++) {
+        char name[4];
+        preflop_class_name(cls, name);
+        int want = name[2] == '\0' ? 6 : name[2] == 's' ? 4 : 12;
+        if (combos[cls] != want) {
+            printf("  %s: %d combos, want %d\n", name, combos[cls], want);
+            failed++;
+        }
+    }
+    printf("TEST preflop hand classes -> %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/* Server/CLI request lines */
+static int test_parse_request(void)
+{
+    char good[] = "Ah Kh Qh Jh 2c 150 40 opponents=2 samples=5000";
+    static const char *bad[] = {"Ah", "Ah Kh Qh", "Ah Kh Qh Jh Ah", "Ah Kh opponents=12", "Ah Kh color=red",
+                                "Ah Kh x y", "Ah Kh 100 -5", "Ah Kh 10x", "Ah Kh opponents=2x"};
+    char *tok[16], err[128];
+    int ntok = 0, failed = 0;
+    request_t req;
+
+    for (char *t = strtok(good, " "); t; t = strtok(NULL, " ")) tok[ntok++] = t;
+    if (!parse_request(tok, ntok, &req, err, sizeof(err)) || req.num_community != 3 ||
+        req.pot != 150 || req.to_call != 40 || req.opponents != 2 || req.samples != 5000) {
+        printf("  valid request rejected or misread\n");
+        failed++;
+    }
+    for (int i = 0; i < (int)(sizeof(bad) / sizeof(bad[0])); i++) {
+        char line[64];
+        strcpy(line, bad[i]);
+        ntok = 0;
+        for (char *t = strtok(line, " "); t; t = strtok(NULL, " ")) tok[ntok++] = t;
+        if (parse_request(tok, ntok, &req, err, sizeof(err))) {
+            printf("  accepted \"%s\"\n", bad[i]);
+            failed++;
+        }
+    }
+    printf("TEST request parsing -> %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/* The library API: one shared context, a private rng per thread */
+#define LIB_THREADS  4
+#define LIB_SPOTS    6
+
+typedef struct {
+    const pa_context_t *ctx;
+    uint64_t            seed;
+    pa_answer_t         ans[LIB_SPOTS];
+    bool                ok;
+} lib_job_t;
+
+static const char *LIB_SPOT_LINES[LIB_SPOTS] = {
+    "Ah Kh Qh Jh 2c 150 40", "7c 2d 30 10", "8c 8d Kh 7s 2d 100 0",
+    "Ah Kd 7c 7d 2s 9h 60 20 opponents=1", "As Ad 30 10 range=QQ+,AK", "9h 8h 7c 6d Ks 100 50 samples=3000",
+};
+
+static void *lib_job(void *arg)
+{
+    lib_job_t *j = arg;
+    pa_rng_t rng;
+    char err[128];
+
+    pa_rng_seed(&rng, j->seed);
+    j->ok = true;
+    for (int i = 0; i < LIB_SPOTS; i++) {
+        char line[64], *tok[16], *save = NULL;
+        int ntok = 0;
+        pa_spot_t spot;
+        strcpy(line, LIB_SPOT_LINES[i]);
+        for (char *t = strtok_r(line, " ", &save); t; t = strtok_r(NULL, " ", &save)) tok[ntok++] = t;
+        j->ok &= pa_spot_parse(tok, ntok, &spot, err, sizeof(err)) &&
+                 pa_advise(j->ctx, &spot, &rng, &j->ans[i], err, sizeof(err));
+    }
+    return NULL;
+}
+
+static int test_library(void)
+{
+    pa_config_t cfg;
+    char err[128];
+    int failed = 0;
+
+    pa_config_default(&cfg);
+    cfg.range = "QQ+/top50%";
+    pa_context_t *ctx = pa_context_new(&cfg, err, sizeof(err));
+    if (!ctx) {
+        printf("  no context: %s\n", err);
+        printf("TEST library API from %d threads -> FAIL\n", LIB_THREADS);
+        return 1;
+    }
+
+    /* The same rng seed answers the same, alone or beside other threads */
+    lib_job_t alone = {ctx, 11, {{0}}, false}, jobs[LIB_THREADS];
+    pthread_t tids[LIB_THREADS];
+    lib_job(&alone);
+    for (int t = 0; t < LIB_THREADS; t++) {
+        jobs[t] = (lib_job_t){ctx, 11 + (uint64_t)(t % 2), {{0}}, false};
+        pthread_create(&tids[t], NULL, lib_job, &jobs[t]);
+    }
+    for (int t = 0; t < LIB_THREADS; t++) pthread_join(tids[t], NULL);
+    for (int t = 0; t < LIB_THREADS; t++)
+        for (int i = 0; i < LIB_SPOTS; i++) {
+            const pa_answer_t *a = &jobs[t].ans[i];
+            bool same = a->win_pct == alone.ans[i].win_pct && a->advice.ev == alone.ans[i].advice.ev;
+            if (!jobs[t].ok || !alone.ok || (t % 2 == 0) != same) {
+                printf("  thread %d, %s: %.6f vs %.6f alone\n", t, LIB_SPOT_LINES[i],
+                    a->win_pct, alone.ans[i].win_pct);
+                failed++;
+            }
+        }
+
+    /* Ranking, and spots the library has to refuse */
+    pa_card_t cards[7];
+    pa_rank_t r;
+    const char *royal[7] = {"Ah","Kh","Qh","Jh","Th","2c","3d"};
+    for (int i = 0; i < 7; i++) pa_card_parse(royal[i], &cards[i]);
+    if (!pa_rank(cards, 7, &r) || r.rankVal != 0 || strcmp(pa_rank_name(r.rankVal), "Royal Flush") != 0) {
+        printf("  royal flush ranked %d\n", r.rankVal);
+        failed++;
+    }
+    pa_spot_t spot;
+    memset(&spot, 0, sizeof(spot));
+    spot.hole[0] = spot.hole[1] = cards[0];
+    spot.pot = 10;
+    spot.to_call = 5;
+    pa_answer_t ans;
+    pa_rng_t rng;
+    pa_rng_seed(&rng, 1);
+    if (pa_advise(ctx, &spot, &rng, &ans, err, sizeof(err)) || pa_rank(cards, 4, &r)) {
+        printf("  accepted a duplicate card or a 4-card hand\n");
+        failed++;
+    }
+    spot.hole[1] = cards[1];
+    spot.range = "ZZ+";
+    if (pa_advise(ctx, &spot, &rng, &ans, err, sizeof(err))) {
+        printf("  accepted range ZZ+\n");
+        failed++;
+    }
+    pa_context_free(ctx);
+
+    cfg.range = "ZZ+";
+    ctx = pa_context_new(&cfg, err, sizeof(err));
+    if (ctx) {
+        printf("  context accepted range ZZ+\n");
+        pa_context_free(ctx);
+        failed++;
+    }
+    printf("TEST library API from %d threads -> %s\n", LIB_THREADS, failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/* Relabeled spots share a canonical form and a cache entry; the LRU entry goes first */
+static int test_cache(void)
+{
+    static const char *lines[] = {
+        "Ah Kh Qh Jh 2c 150 40", "As Ks Qs Js 2d 150 40", "8c 8d Kh 7s 2d 100 0",
+        "9h 8h 7c 6d Ks 100 50", "Ah Kh Qh Jh 2c 150 40", "As Ad 30 10 range=QQ+",
+        "As Ad 30 10 range=QQ+",
+    };
+    static const bool want_cached[] = {false, true, false, false, false, false, false};
+    pa_answer_t ans[7];
+    pa_config_t cfg;
+    pa_rng_t rng;
+    char err[128];
+    int failed = 0;
+
+    /* Every relabeling of the suits, and no different spot, gives the same form */
+    static const int perms[24][4] = {
+        {0,1,2,3},{0,1,3,2},{0,2,1,3},{0,2,3,1},{0,3,1,2},{0,3,2,1},{1,0,2,3},{1,0,3,2},
+        {1,2,0,3},{1,2,3,0},{1,3,0,2},{1,3,2,0},{2,0,1,3},{2,0,3,1},{2,1,0,3},{2,1,3,0},
+        {2,3,0,1},{2,3,1,0},{3,0,1,2},{3,0,2,1},{3,1,0,2},{3,1,2,0},{3,2,0,1},{3,2,1,0},
+    };
+    cardmask_t hole = 0x1ULL << 12 | 0x1ULL << 11, board = 0x1ULL << 10 | 0x1ULL << 9 | 0x1ULL << 26;
+    cardmask_t ch = hole, cb = board;
+    canonical_spot(&ch, &cb);
+    for (int p = 0; p < 24; p++) {
+        cardmask_t h = 0, b = 0;
+        for (int s = 0; s < 4; s++) {
+            h |= ((hole >> (13 * s)) & 0x1FFF) << (13 * perms[p][s]);
+            b |= ((board >> (13 * s)) & 0x1FFF) << (13 * perms[p][s]);
+        }
+        canonical_spot(&h, &b);
+        if (h != ch || b != cb) {
+            printf("  relabeling %d has another canonical form\n", p);
+            failed++;
+        }
+    }
+    cardmask_t h = 0x1ULL << 12 | 0x1ULL << 24, b = board;   /* AhKs: offsuit */
+    canonical_spot(&h, &b);
+    if (h == ch && b == cb) {
+        printf("  AhKh and AhKs share a canonical form\n");
+        failed++;
+    }
+
+    pa_config_default(&cfg);
+    cfg.cache_entries = 2;
+    pa_context_t *ctx = pa_context_new(&cfg, err, sizeof(err));
+    pa_rng_seed(&rng, 5);
+    for (int i = 0; i < 7; i++) {
+        char line[64], *tok[16], *save = NULL;
+        int ntok = 0;
+        pa_spot_t spot;
+        strcpy(line, lines[i]);
+        for (char *t = strtok_r(line, " ", &save); t; t = strtok_r(NULL, " ", &save)) tok[ntok++] = t;
+        if (!pa_spot_parse(tok, ntok, &spot, err, sizeof(err)) ||
+            !pa_advise(ctx, &spot, &rng, &ans[i], err, sizeof(err)) || ans[i].cached != want_cached[i]) {
+            printf("  %s: cached %d, want %d\n", lines[i], ans[i].cached, want_cached[i]);
+            failed++;
+        }
+    }
+    long hits, misses;
+    pa_context_cache_stats(ctx, &hits, &misses);
+    if (ans[1].win_pct != ans[0].win_pct || ans[4].win_pct != ans[0].win_pct ||
+        ans[1].advice.ev != ans[0].advice.ev || hits != 1 || misses != 4) {
+        printf("  equity %.4f, relabeled %.4f, after eviction %.4f; %ld hits, %ld misses\n",
+            ans[0].win_pct, ans[1].win_pct, ans[4].win_pct, hits, misses);
+        failed++;
+    }
+    pa_context_free(ctx);
+    printf("TEST suit-canonical equity cache -> %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/* Batch spots: CSV, JSON and request lines all become the same request */
+static int test_parse_spot(void)
+{
+    static const char *same[] = {
+        "AhKh,QhJh2c,150,40,2\n",
+        "{\"hole\": \"AhKh\", \"board\": \"QhJh2c\", \"pot\": 150, \"to_call\": 40, \"opponents\": 2}\n",
+        "Ah Kh Qh Jh 2c 150 40 opponents=2\n",
+    };
+    static const char *bad[] = {"AhKh,Qh,10,5", "AhAh,,10,5", "{\"board\":\"QhJh2c\"}", "AhKh,,10,5,12"};
+    char line[PA_MAX_LINE], err[128];
+    request_t req;
+    int failed = 0;
+
+    for (int i = 0; i < 3; i++) {
+        strcpy(line, same[i]);
+        if (!pa_spot_parse_line(line, &req, err, sizeof(err)) || req.num_community != 3 ||
+            req.community[2].face != 0 || req.pot != 150 || req.to_call != 40 || req.opponents != 2) {
+            printf("  misread %s", same[i]);
+            failed++;
+        }
+    }
+    strcpy(line, "AhKh,,10,5\n");
+    if (!pa_spot_parse_line(line, &req, err, sizeof(err)) || req.num_community != 0 || req.opponents != 0) {
+        printf("  misread a preflop spot without opponents\n");
+        failed++;
+    }
+    strcpy(line, "AhKhQdJd,QhJh2c,150,40\n");
+    if (!pa_spot_parse_line(line, &req, err, sizeof(err)) || req.game != PA_GAME_OMAHA ||
+        req.hole[3].face != 9 || req.num_community != 3) {
+        printf("  misread an Omaha spot\n");
+        failed++;
+    }
+    for (int i = 0; i < 4; i++) {
+        strcpy(line, bad[i]);
+        if (pa_spot_parse_line(line, &req, err, sizeof(err))) {
+            printf("  accepted %s\n", bad[i]);
+            failed++;
+        }
+    }
+    printf("TEST batch spot parsing -> %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+/* Range notation: holdings covered, bad items rejected, sampled equity */
+static int test_ranges(void)
+{
+    static const struct { const char *spec; int combos; } good[] = {
+        {"QQ+,AKs", 22}, {"ATo+", 48}, {"TT-77", 24}, {"K9s-K6s", 16}, {"AK", 16},
+        {"AhKd", 1}, {"random", 1326}, {"top100%", 1326}, {"22+,AQs:0.5", 82},
+    };
+    static const char *bad[] = {"AKp", "QQs", "K9s-Q6s", "AA:2", "top0%", "AhAh", "", "AK,,Z"};
+    static range_t ranges[MAX_OPPONENTS];
+    char err[128];
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(good) / sizeof(good[0]); i++) {
+        int n = 0;
+        if (range_parse(ranges, good[i].spec, err, sizeof(err)) != 1) {
+            printf("  rejected \"%s\": %s\n", good[i].spec, err);
+            failed++;
+            continue;
+        }
+        for (int c = 0; c < NUM_COMBOS; c++) n += ranges[0].weight[c] > 0.0f;
+        if (n != good[i].combos) {
+            printf("  \"%s\": %d holdings, want %d\n", good[i].spec, n, good[i].combos);
+            failed++;
+        }
+    }
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+        if (range_parse(ranges, bad[i], err, sizeof(err)) != 0) {
+            printf("  accepted \"%s\"\n", bad[i]);
+            failed++;
+        }
+
+    /* Top 10% must hold about 133 of the 1326 holdings, best hands first */
+    int n = 0;
+    range_parse(ranges, "top10%", err, sizeof(err));
+    for (int c = 0; c < NUM_COMBOS; c++) n += ranges[0].weight[c] > 0.0f;
+    if (n < 133 || n > 145 || ranges[0].weight[holding_index(12, 25)] == 0.0f ||
+        ranges[0].weight[holding_index(0, 18)] != 0.0f) {
+        printf("  top10%%: %d holdings\n", n);
+        failed++;
+    }
+
+    /* AhAs against KK heads-up wins about 82%; a "random" range matches no range */
+    card_t cards[5];
+    const char *names[5] = {"Ah","As","Kd","7c","2h"};
+    rank_t current;
+    sim_opts_t opts = sim_opts_default();
+    for (int i = 0; i < 5; i++) parse_card(names[i], &cards[i]);
+    opts.opponents = 1;
+    opts.trials = 200000;
+    opts.target_se = 0;
+    opts.seed = 3;
+    opts.num_ranges = range_parse(ranges, "KK", err, sizeof(err));
+    opts.ranges = ranges;
+    double kk = simulate(cards_mask(cards, 2), 0, &current, &opts, NULL);
+
+    sim_result_t res;
+    opts.opponents = 3;
+    opts.num_ranges = range_parse(ranges, "random", err, sizeof(err));
+    double ranged = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 3), &current, &opts, &res);
+    opts.num_ranges = 0;
+    double uniform = simulate(cards_mask(cards, 2), cards_mask(cards + 2, 3), &current, &opts, NULL);
+    if (kk < 0.81 || kk > 0.83 || ranged - uniform > 0.006 || uniform - ranged > 0.006 ||
+        res.method != PA_MONTE_CARLO || res.outcomes != opts.trials) {
+        printf("  AA vs KK %.4f, random range %.4f vs uniform %.4f\n", kk, ranged, uniform);
+        failed++;
+    }
+    printf("TEST opponent ranges -> %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+
+int main(void)
+{
+    card_t deck[DECK_SIZE];
+    int failures = 0;
+
+    for (int i = 0; i < DECK_SIZE; i++) { deck[i].face = i % 13; deck[i].suit = i / 13; }
+    eval_init();
+    build_ref5(deck);
+    failures += test_ordering();
+    failures += test_simulate();
+    failures += test_action_values();
+    failures += test_determinism();
+    failures += test_exact();
+    failures += test_adaptive();
+    failures += test_opponents();
+    failures += test_histogram();
+    failures += test_stratified();
+    failures += test_side_pots();
+    failures += test_omaha();
+    failures += test_outs();
+    failures += test_preflop_classes();
+    failures += test_parse_request();
+    failures += test_parse_spot();
+    failures += test_library();
+    failures += test_cache();
+    failures += test_ranges();
+    failures += test_all_hands(deck, 5);
+    failures += test_all_hands(deck, 6);
+    failures += test_all_hands(deck, 7);
+
+    free(ref5);
+    printf("\n%s\n", failures ? "SOME TESTS FAILED" : "ALL TESTS PASSED");
+    return failures ? 1 : 0;
+}
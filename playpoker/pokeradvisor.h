@@ -0,0 +1,223 @@
+/********************************************************************
+  Author: Vikas Yadav
+  Filename: pokeradvisor.h
+  Copyright (c) 2017-2026 Vikas Yadav. All rights reserved.
+
+  libpokeradvisor: hand ranking, equity and betting advice as a
+  reentrant C library. poker_advisor is a thin front end over it.
+
+  Build:  gcc -O2 -pthread -c libpokeradvisor.c
+          ar rcs libpokeradvisor.a libpokeradvisor.o
+  Link:   gcc -O2 -pthread -o app app.c libpokeradvisor.a -lm
+
+  State lives in two explicit objects, and there is no mutable global
+  state besides the evaluator's lookup tables, which are built once on
+  first use (pthread_once) and only read afterwards:
+    pa_context_t  configuration, default opponent ranges, the
+                  memory-mapped preflop table and an optional equity
+                  cache; read-only once created apart from the cache,
+                  which locks itself, so any number of threads may
+                  share one
+    pa_rng_t      a random stream; give each thread its own
+
+  Usage:
+    pa_config_t cfg;
+    pa_config_default(&cfg);
+    cfg.preflop_table = "preflop_equity.bin";
+    pa_context_t *ctx = pa_context_new(&cfg, err, sizeof(err));
+
+    pa_rng_t rng;                     (one per thread)
+    pa_rng_seed(&rng, 42);
+    pa_spot_t spot;
+    pa_spot_parse(tok, ntok, &spot, err, sizeof(err));   (or fill it in)
+    pa_answer_t ans;
+    if (pa_advise(ctx, &spot, &rng, &ans, err, sizeof(err)))
+        printf("%s %d\n", ans.advice.action, ans.advice.amount);
+    pa_context_free(ctx);
+********************************************************************/
+#ifndef POKERADVISOR_H
+#define POKERADVISOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PA_MAX_OPPONENTS    9    /* MAX_PLAYERS seats in PlayPoker.c less the hero */
+#define PA_NUM_RANKS        10
+#define PA_EQUITY_BUCKETS   10   /* next-street equity histogram bins, 10% each */
+#define PA_NUM_RAISE_SIZES  5
+#define PA_MAX_THREADS      256  /* simulation threads per spot */
+#define PA_MAX_CACHE_ENTRIES  (1 << 20)
+#define PA_MAX_LINE         1024 /* longest spot line, newline included */
+
+typedef struct {
+    int face; /* 0=2, 1=3, ..., 12=A */
+    int suit; /* 0=heart, 1=spade, 2=club, 3=diamond */
+} pa_card_t;
+
+typedef struct {
+    int rankVal;  /* 0=Royal Flush .. 9=High Card */
+    int high;
+    int high2;
+    int kicker;
+} pa_rank_t;
+
+/* How Monte Carlo trials are drawn; see pa_sim_t.variance_reduction */
+typedef enum {
+    PA_SAMPLE_DEFAULT,     /* in a spot: the context's; in a config: plain */
+    PA_SAMPLE_PLAIN,       /* independent deals */
+    PA_SAMPLE_STRATIFIED   /* on the flop and turn, cycle through every runout */
+                           /* of the board, dealing opponents at random */
+} pa_sampling_t;
+
+/* Defaults for every spot answered with a context */
+typedef struct {
+    int         opponents;      /* random opponent hands, 1..PA_MAX_OPPONENTS */
+    int         trials;         /* Monte Carlo sample cap */
+    int         threads;        /* simulation threads per spot */
+    double      exact_budget;   /* enumerate exactly when outcomes <= this (0: never) */
+    double      target_se;      /* stop once the equity's standard error is this small (0: off) */
+    double      max_ms;         /* stop after this much wall time (0: no limit) */
+    int         hist_samples;   /* nested samples per trial for the next-street */
+                                /* equity histogram (0: off) */
+    const char *range;          /* opponent range notation, NULL: random hands */
+    const char *preflop_table;  /* table from preflop_table_gen, NULL: none */
+    int         cache_entries;  /* spots whose answers are kept, least recently */
+                                /* used evicted first (0: no cache) */
+    pa_sampling_t sampling;
+} pa_config_t;
+
+typedef struct pa_context pa_context_t;
+
+typedef struct {
+    uint64_t s[4];
+} pa_rng_t;
+
+/* Which hand each player holds */
+typedef enum {
+    PA_GAME_HOLDEM,   /* two hole cards, any five of seven */
+    PA_GAME_OMAHA     /* four hole cards, exactly two of them with three */
+                      /* of the board */
+} pa_game_t;
+
+/* One spot to answer: the CLI's positional arguments, or one server line */
+typedef struct {
+    pa_card_t   hole[4];     /* [0..1]; Omaha: [0..3] */
+    pa_card_t   community[5];
+    int         num_community;
+    int         pot, to_call;
+    int         opponents;   /* 0: the context's */
+    int         samples;     /* Monte Carlo sample cap, 0: the context's */
+    uint64_t    seed;        /* 0: drawn from the caller's pa_rng_t */
+    const char *range;       /* opponent range notation, NULL: the context's */
+    int         histogram;   /* nested samples for the equity histogram, 0: the context's */
+    int         threads;     /* simulation threads, 0: the context's */
+    pa_sampling_t sampling;
+    int         num_stacks;  /* 0: one pot; else opponents + 1 */
+    int         stacks[PA_MAX_OPPONENTS + 1];   /* chips each player still puts */
+                             /* in, all in, hero first; pot is dead money. */
+                             /* Prices side pots in pa_sim_t.chips and */
+                             /* caps raises at the effective stack */
+    pa_game_t   game;        /* opponent ranges and the preflop table */
+                             /* are hold'em only */
+} pa_spot_t;
+
+/* How a spot line is written (pa_spot_parse_line()): the CLI's arguments */
+/* and key=value fields, CSV "hole,board,pot,to_call[,opponents]" such */
+/* as "AhKh,QhJh2c,150,40,3" (four hole cards: Omaha), or a flat JSON */
+/* object with those keys */
+typedef enum { PA_LINE_REQUEST, PA_LINE_CSV, PA_LINE_JSON } pa_line_format_t;
+
+typedef enum { PA_MONTE_CARLO, PA_EXACT, PA_TABLE } pa_method_t;
+typedef enum { PA_STOP_DONE, PA_STOP_TARGET, PA_STOP_SAMPLES, PA_STOP_TIME } pa_stop_t;
+
+/* How an equity figure was obtained */
+typedef struct {
+    pa_method_t  method;
+    pa_stop_t    stop;          /* why sampling ended (PA_STOP_DONE when exact) */
+    long         outcomes;      /* trials sampled, or showdowns enumerated */
+                                /* (for PA_TABLE, trials behind the entry) */
+    long         evaluations;   /* 7-card hand evaluations performed */
+    long         dropped;       /* sampled deals discarded: ranged holdings shared a card */
+    double       std_error;     /* standard error of the equity (0 when exact) */
+    pa_sampling_t sampling;     /* PA_SAMPLE_STRATIFIED when it was used: only on */
+                                /* the flop and turn, without ranges or a histogram */
+    double       variance_reduction;   /* plain sampling's variance over this */
+                                /* one's: its trials per trial here (1 when plain) */
+    long         hist[PA_EQUITY_BUCKETS];  /* trials by hero equity once the next */
+                                /* street is out (hist_samples > 0) */
+    long         hist_trials;   /* trials in hist; 0 when not computed */
+    double       hist_mean;     /* mean and standard deviation of those equities */
+    double       hist_sd;
+    double       eq_vs[PA_MAX_OPPONENTS + 1];   /* [k]: equity against the first k */
+                                /* opponents alone; [opponents] is the equity */
+    double       chips;         /* with stacks: chips the hero expects back */
+                                /* from the main and side pots */
+} pa_sim_t;
+
+/* Outs on the flop and turn */
+typedef struct {
+    int    unseen;                 /* cards that can come next; 0 preflop and on the river */
+    int    outs;
+    int    by_rank[PA_NUM_RANKS];  /* outs by the rankVal they make */
+    double improve_next;           /* chance the next card is an out */
+    double improve_river;          /* chance of improving by the river */
+} pa_outs_t;
+
+/* The recommended action and what every action is worth */
+typedef struct {
+    const char *action;   /* "FOLD", "CHECK", "CALL", "RAISE" */
+    int         amount;   /* raise over the call, the call itself, or 0 */
+    double      win_pct;
+    const char *strength; /* "Very Strong", "Strong", "Medium", "Weak", "Very Weak" */
+    double      ev;       /* chips the action is worth */
+    double      ev_call;  /* checking or calling */
+    int         raise[PA_NUM_RAISE_SIZES];     /* raise sizes tried; 0 when the */
+                                               /* stacks leave no raise */
+    double      ev_raise[PA_NUM_RAISE_SIZES];
+} pa_advice_t;
+
+/* Everything an advice response reports */
+typedef struct {
+    int         opponents;
+    double      win_pct;
+    pa_rank_t   current;
+    pa_sim_t    sim;
+    pa_outs_t   outs;      /* pa_advise() only */
+    pa_advice_t advice;    /* pa_advise() only */
+    bool        cached;    /* equity taken from the context's cache */
+} pa_answer_t;
+
+/* Contexts */
+void          pa_config_default(pa_config_t *cfg);
+pa_context_t *pa_context_new(const pa_config_t *cfg, char *err, size_t errlen);
+void          pa_context_free(pa_context_t *ctx);
+bool          pa_context_has_preflop(const pa_context_t *ctx);
+void          pa_context_cache_stats(const pa_context_t *ctx, long *hits, long *misses);
+void          pa_rng_seed(pa_rng_t *rng, uint64_t seed);
+
+/* Cards and spots */
+bool        pa_card_parse(const char *s, pa_card_t *c);        /* "Ah", "Td", ... */
+void        pa_card_format(pa_card_t c, char out[4]);
+const char *pa_rank_name(int rankVal);                         /* "N/A" when out of range */
+void        pa_hand_class(const pa_card_t hole[2], char name[4]);   /* "AKs", "T9o", "77" */
+bool        pa_spot_parse(char **tok, int ntok, pa_spot_t *spot, char *err, size_t errlen);
+pa_line_format_t pa_spot_line_format(const char *line);
+bool        pa_spot_parse_line(char *line, pa_spot_t *spot, char *err, size_t errlen);
+
+/*
+ * Answers. Each call is a pure function of its arguments. The state it
+ * changes is the caller's rng, which seeds the spot when spot->seed is
+ * 0, and the context's equity cache, the one mutable part of a context,
+ * which locks itself. With a cache, such a spot is seeded from its
+ * suit-canonical form instead, so the answer does not depend on which
+ * spots were asked before it. Returns false with a message in err when
+ * the spot is invalid.
+ */
+bool pa_rank(const pa_card_t *cards, int n, pa_rank_t *out);   /* best hand of 5..7 cards */
+bool pa_equity(const pa_context_t *ctx, const pa_spot_t *spot, pa_rng_t *rng,
+               pa_answer_t *ans, char *err, size_t errlen);
+bool pa_advise(const pa_context_t *ctx, const pa_spot_t *spot, pa_rng_t *rng,
+               pa_answer_t *ans, char *err, size_t errlen);
+
+#endif  /* POKERADVISOR_H */
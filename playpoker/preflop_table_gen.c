@@ -0,0 +1,142 @@
+/********************************************************************
+  Author: Vikas Yadav
+  Filename: preflop_table_gen.c
+  Copyright (c) 2017-2026 Vikas Yadav. All rights reserved.
+
+  Generates the preflop equity table poker_advisor memory-maps for
+  instant preflop advice: equity of all 169 canonical starting hands
+  against 1 to 9 random opponents, with the sample count and standard
+  error of every entry so the table's precision is known.
+
+  Entries are handed out to one worker per core; each entry is seeded
+  from (seed, hand, opponents), so the table is reproducible regardless
+  of how many cores built it.
+
+  Build:  gcc -O2 -pthread -o preflop_table_gen preflop_table_gen.c -lm
+  Usage:  ./preflop_table_gen [--samples N] [--threads N] [--seed S] [output]
+          (default: 200000 samples per entry, all cores, preflop_equity.bin)
+********************************************************************/
+#include "libpokeradvisor.c"
+
+#define GEN_SAMPLES  200000
+#define NUM_ENTRIES  (PREFLOP_CLASSES * MAX_OPPONENTS)
+
+typedef struct {
+    preflop_entry_t *entries;
+    int              samples;
+    uint64_t         seed;
+    int              next;      /* next entry to compute, under lock */
+    pthread_mutex_t  lock;
+} gen_job_t;
+
+/* Representative hole cards for a class: hearts, plus spades if offsuit */
+static void class_cards(int cls, card_t hole[2])
+{
+    int row = cls / 13, col = cls % 13;
+    hole[0].face = row > col ? row : col;
+    hole[1].face = row > col ? col : row;
+    hole[0].suit = 0;
+    hole[1].suit = (row > col) ? 0 : 1;
+}
+
+static void *gen_worker(void *arg)
+{
+    gen_job_t *job = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int e = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (e >= NUM_ENTRIES) break;
+
+        int cls = e / MAX_OPPONENTS;
+        card_t hole[2];
+        rank_t current;
+        sim_result_t res;
+        sim_opts_t opts = sim_opts_default();
+
+        class_cards(cls, hole);
+        opts.opponents = e % MAX_OPPONENTS + 1;
+        opts.trials = job->samples;
+        opts.target_se = 0;
+        opts.exact_budget = 0;
+        opts.seed = job->seed ^ ((uint64_t)e * 0x9E3779B97F4A7C15ULL);
+
+        double eq = simulate(cards_mask(hole, 2), 0, &current, &opts, &res);
+        job->entries[e].equity = (float)eq;
+        job->entries[e].std_error = (float)res.std_error;
+        job->entries[e].samples = (uint32_t)res.outcomes;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = PREFLOP_FILE;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    gen_job_t job;
+
+    job.samples = GEN_SAMPLES;
+    job.seed = 2017;
+    job.next = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--samples") == 0 && i+1 < argc) job.samples = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) job.seed = strtoull(argv[++i], NULL, 0);
+        else path = argv[i];
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if (job.samples < 1) {
+        printf("Error: --samples must be at least 1.\n");
+        return 1;
+    }
+
+    eval_init();
+    job.entries = calloc(NUM_ENTRIES, sizeof(preflop_entry_t));
+    pthread_mutex_init(&job.lock, NULL);
+
+    printf("Computing %d entries x %d samples on %d thread%s...\n",
+        NUM_ENTRIES, job.samples, threads, threads == 1 ? "" : "s");
+    pthread_t tids[MAX_THREADS];
+    int started = 0;
+    for (int t = 0; t < threads; t++, started++)
+        if (pthread_create(&tids[t], NULL, gen_worker, &job) != 0)
+            break;
+    if (started == 0) gen_worker(&job);
+    for (int t = 0; t < started; t++)
+        pthread_join(tids[t], NULL);
+
+    preflop_header_t h;
+    memcpy(h.magic, PREFLOP_MAGIC, 4);
+    h.version = PREFLOP_VERSION;
+    h.num_classes = PREFLOP_CLASSES;
+    h.max_opponents = MAX_OPPONENTS;
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp || fwrite(&h, sizeof(h), 1, fp) != 1 ||
+        fwrite(job.entries, sizeof(preflop_entry_t), NUM_ENTRIES, fp) != NUM_ENTRIES) {
+        printf("Error: cannot write %s\n", path);
+        if (fp) fclose(fp);
+        return 1;
+    }
+    fclose(fp);
+
+    /* A few reference rows */
+    static const char *show[] = {"AA", "AKs", "AKo", "72o"};
+    for (int i = 0; i < 4; i++)
+        for (int cls = 0; cls < PREFLOP_CLASSES; cls++) {
+            char name[4];
+            preflop_class_name(cls, name);
+            if (strcmp(name, show[i]) != 0) continue;
+            printf("%-4s", name);
+            for (int o = 0; o < MAX_OPPONENTS; o++)
+                printf(" %5.1f%%", job.entries[cls * MAX_OPPONENTS + o].equity * 100.0);
+            printf("\n");
+        }
+    printf("Wrote %s\n", path);
+
+    pthread_mutex_destroy(&job.lock);
+    free(job.entries);
+    return 0;
+}
@@ -0,0 +1,273 @@
+/********************************************************************
+  Author: Vikas Yadav
+  Filename: range_matrix.c
+  Copyright (c) 2017-2026 Vikas Yadav. All rights reserved.
+
+  Range-vs-range equity matrix: the equity of every one of the 1326
+  hole-card holdings against every other on a given board, written as a
+  dense binary matrix for training and bot tuning.
+
+  Each board runout is evaluated once for every holding (with the same
+  tables best_hand() uses, so cells agree with single-spot advice), and
+  every pair of holdings on that runout is then settled by comparing two
+  stored values. Runouts are evaluated in parallel, then rows of the
+  matrix are accumulated in parallel, so no thread needs a private copy.
+  Flop, turn and river boards enumerate every runout; preflop (or with
+  --runouts N) samples N random boards instead.
+
+  With --hero and --villain ranges (poker_advisor --range notation) the
+  weighted range-vs-range equity is printed as well.
+
+  Build:  gcc -O2 -pthread -o range_matrix range_matrix.c -lm
+  Usage:  ./range_matrix [--threads N] [--runouts N] [--seed S]
+                         [--hero SPEC --villain SPEC] [board cards] [output]
+          (default: all cores, every runout, range_matrix.bin)
+
+  Output: a matrix_header_t, then float m[1326][1326] in holding_index()
+  order (cards as bit positions suit*13+face, "hscd" suits): m[h][v] is
+  the equity of h against v, ties counting half; NaN where the two
+  holdings share a card or touch the board.
+********************************************************************/
+#include "libpokeradvisor.c"
+
+#define MATRIX_MAGIC     "RVRM"
+#define MATRIX_VERSION   1
+#define MATRIX_FILE      "range_matrix.bin"
+#define MATRIX_SAMPLED   10000   /* preflop runouts when --runouts is not given */
+
+typedef struct {
+    char     magic[4];
+    uint32_t version;
+    uint32_t num_combos;    /* NUM_COMBOS, in holding_index() order */
+    uint32_t runouts;       /* board completions evaluated */
+    uint64_t board;         /* known board cards as a card mask */
+} matrix_header_t;
+
+typedef struct {
+    cardmask_t  combo[NUM_COMBOS];  /* holding_index() -> cards */
+    int         num_runouts;
+    cardmask_t *runout;             /* complete 5-card boards */
+    hand_val_t *val;                /* [runout][holding], 0 if they overlap */
+    float      *matrix;             /* [hero][villain] */
+    int         next;               /* next runout or row to claim */
+} matrix_job_t;
+
+static void *eval_worker(void *arg)
+{
+    matrix_job_t *job = arg;
+    int r;
+
+    while ((r = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->num_runouts) {
+        hand_val_t *val = &job->val[(size_t)r * NUM_COMBOS];
+        board_eval_t be;
+        board_prepare(&be, job->runout[r]);
+        for (int c = 0; c < NUM_COMBOS; c++)
+            val[c] = (job->combo[c] & job->runout[r]) ? 0 : board_finish(&be, job->combo[c]);
+    }
+    return NULL;
+}
+
+/*
+ * Row h against every later holding v; the mirror cell is 1 - m[h][v].
+ * Per runout, a pair counts only if neither holding touches it: num
+ * gathers 2 per win and 1 per tie, den the runouts counted.
+ */
+static void *row_worker(void *arg)
+{
+    matrix_job_t *job = arg;
+    uint32_t num[NUM_COMBOS], den[NUM_COMBOS];
+    int h;
+
+    while ((h = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < NUM_COMBOS) {
+        memset(num, 0, sizeof(num));
+        memset(den, 0, sizeof(den));
+        for (int r = 0; r < job->num_runouts; r++) {
+            cardmask_t dead = job->runout[r] | job->combo[h];
+            if (job->combo[h] & job->runout[r]) continue;
+            const hand_val_t *val = &job->val[(size_t)r * NUM_COMBOS];
+            hand_val_t hv = val[h];
+            for (int v = h + 1; v < NUM_COMBOS; v++) {
+                uint32_t ok = (job->combo[v] & dead) == 0;
+                num[v] += ok * (2u * (hv > val[v]) + (hv == val[v]));
+                den[v] += ok;
+            }
+        }
+        float *row = &job->matrix[(size_t)h * NUM_COMBOS];
+        row[h] = NAN;
+        for (int v = h + 1; v < NUM_COMBOS; v++) {
+            float eq = den[v] ? (float)num[v] / (2.0f * (float)den[v]) : NAN;
+            row[v] = eq;
+            job->matrix[(size_t)v * NUM_COMBOS + h] = 1.0f - eq;
+        }
+    }
+    return NULL;
+}
+
+/* Run fn on this thread and threads-1 more until the job is drained */
+static void run_pool(void *(*fn)(void *), matrix_job_t *job, int threads)
+{
+    pthread_t tids[MAX_THREADS];
+    int started = 1;
+
+    job->next = 0;
+    for (int t = 1; t < threads; t++, started++)
+        if (pthread_create(&tids[t], NULL, fn, job) != 0)
+            break;
+    fn(job);
+    for (int t = 1; t < started; t++)
+        pthread_join(tids[t], NULL);
+}
+
+/* Every k-card completion of the board from the live cards */
+static int enumerate_runouts(cardmask_t board, cardmask_t live, int k, cardmask_t *out)
+{
+    int n = 0, idx[5], cards[DECK_SIZE], count = 0;
+
+    for (cardmask_t m = live; m; m &= m - 1) cards[n++] = __builtin_ctzll(m);
+    for (int i = 0; i < k; i++) idx[i] = i;
+    for (;;) {
+        cardmask_t r = board;
+        for (int i = 0; i < k; i++) r |= 1ULL << cards[idx[i]];
+        out[count++] = r;
+
+        int p = k - 1;
+        while (p >= 0 && idx[p] == n - k + p) p--;
+        if (p < 0) break;
+        idx[p]++;
+        for (int i = p+1; i < k; i++) idx[i] = idx[i-1] + 1;
+    }
+    return count;
+}
+
+/* Weighted equity of one range against another over the defined cells */
+static double range_equity(const float *matrix, const range_t *hero, const range_t *villain)
+{
+    double sum = 0.0, weight = 0.0;
+
+    for (int h = 0; h < NUM_COMBOS; h++) {
+        if (hero->weight[h] <= 0.0f) continue;
+        for (int v = 0; v < NUM_COMBOS; v++) {
+            float eq = matrix[(size_t)h * NUM_COMBOS + v];
+            if (villain->weight[v] <= 0.0f || isnan(eq)) continue;
+            double w = (double)hero->weight[h] * villain->weight[v];
+            sum += w * eq;
+            weight += w;
+        }
+    }
+    return weight > 0.0 ? sum / weight : NAN;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = MATRIX_FILE, *hero_spec = NULL, *villain_spec = NULL;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN), sampled = 0;
+    uint64_t seed = 2017;
+    card_t board_cards[5];
+    int num_board = 0;
+    static matrix_job_t job;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--runouts") == 0 && i+1 < argc) sampled = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--hero") == 0 && i+1 < argc) hero_spec = argv[++i];
+        else if (strcmp(argv[i], "--villain") == 0 && i+1 < argc) villain_spec = argv[++i];
+        else if (strlen(argv[i]) == 2 && num_board < 5 && parse_card(argv[i], &board_cards[num_board]))
+            num_board++;
+        else path = argv[i];
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    cardmask_t board = cards_mask(board_cards, num_board);
+    if (num_board == 1 || num_board == 2 || mask_count(board) != num_board) {
+        printf("Error: the board must be 0, 3, 4 or 5 distinct cards.\n");
+        return 1;
+    }
+    if (num_board == 0 && sampled == 0) sampled = MATRIX_SAMPLED;
+    if (sampled < 0) sampled = 0;
+
+    static range_t hero[MAX_OPPONENTS], villain[MAX_OPPONENTS];
+    char err[128];
+    if ((hero_spec && !range_parse(hero, hero_spec, err, sizeof(err))) ||
+        (villain_spec && !range_parse(villain, villain_spec, err, sizeof(err)))) {
+        printf("Error: %s\n", err);
+        return 1;
+    }
+
+    eval_init();
+    for (int a = 0; a < DECK_SIZE; a++)
+        for (int b = a+1; b < DECK_SIZE; b++)
+            job.combo[holding_index(a, b)] = (1ULL << a) | (1ULL << b);
+
+    /* Runouts: all of them, or a sample of random completions */
+    cardmask_t live = FULL_DECK & ~board;
+    int k = 5 - num_board;
+    if (sampled) {
+        uint8_t deck[DECK_SIZE], pos[DECK_SIZE];
+        int n = 0;
+        rng_t rng;
+        rng_seed(&rng, seed);
+        for (cardmask_t m = live; m; m &= m - 1) {
+            pos[__builtin_ctzll(m)] = (uint8_t)n;
+            deck[n++] = (uint8_t)__builtin_ctzll(m);
+        }
+        job.runout = malloc(sizeof(cardmask_t) * (size_t)sampled);
+        for (int r = 0; r < sampled; r++) {
+            job.runout[r] = board;
+            for (int i = 0; i < k; i++) job.runout[r] |= deck_draw(deck, pos, n, i, &rng);
+        }
+        job.num_runouts = sampled;
+    } else {
+        job.runout = malloc(sizeof(cardmask_t) * (size_t)choose(mask_count(live), k));
+        job.num_runouts = enumerate_runouts(board, live, k, job.runout);
+    }
+    job.val = malloc(sizeof(hand_val_t) * NUM_COMBOS * (size_t)job.num_runouts);
+    job.matrix = malloc(sizeof(float) * NUM_COMBOS * NUM_COMBOS);
+
+    printf("Evaluating %d %s runout%s x %d holdings on %d thread%s...\n",
+        job.num_runouts, sampled ? "sampled" : "enumerated", job.num_runouts == 1 ? "" : "s",
+        NUM_COMBOS, threads, threads == 1 ? "" : "s");
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_pool(eval_worker, &job, threads);
+    run_pool(row_worker, &job, threads);
+    printf("Done in %.0f ms\n", elapsed_ms(&start));
+
+    matrix_header_t h;
+    memcpy(h.magic, MATRIX_MAGIC, 4);
+    h.version = MATRIX_VERSION;
+    h.num_combos = NUM_COMBOS;
+    h.runouts = (uint32_t)job.num_runouts;
+    h.board = board;
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp || fwrite(&h, sizeof(h), 1, fp) != 1 ||
+        fwrite(job.matrix, sizeof(float), (size_t)NUM_COMBOS * NUM_COMBOS, fp) !=
+            (size_t)NUM_COMBOS * NUM_COMBOS) {
+        printf("Error: cannot write %s\n", path);
+        if (fp) fclose(fp);
+        return 1;
+    }
+    fclose(fp);
+
+    /* A reference cell, then the range summary if asked for */
+    static const char *show[2] = {"AhKh", "QsQd"};
+    card_t c[4];
+    parse_card(show[0], &c[0]); parse_card(show[0] + 2, &c[1]);
+    parse_card(show[1], &c[2]); parse_card(show[1] + 2, &c[3]);
+    int a0 = c[0].suit*13 + c[0].face, a1 = c[1].suit*13 + c[1].face;
+    int b0 = c[2].suit*13 + c[2].face, b1 = c[3].suit*13 + c[3].face;
+    float ref = job.matrix[(size_t)holding_index(a0 < a1 ? a0 : a1, a0 < a1 ? a1 : a0) * NUM_COMBOS +
+                           holding_index(b0 < b1 ? b0 : b1, b0 < b1 ? b1 : b0)];
+    if (!isnan(ref)) printf("%s vs %s: %.1f%%\n", show[0], show[1], ref * 100.0);
+    if (hero_spec && villain_spec)
+        printf("%s vs %s: %.1f%%\n", hero_spec, villain_spec,
+            range_equity(job.matrix, &hero[0], &villain[0]) * 100.0);
+    printf("Wrote %s\n", path);
+
+    free(job.runout);
+    free(job.val);
+    free(job.matrix);
+    return 0;
+}
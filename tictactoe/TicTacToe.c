@@ -46,6 +46,8 @@
 #include <stdbool.h>
 #include <time.h>
 
+#include "../util/rng.h"
+
 
 #ifndef DIM  // can define from outside via build option as well
 #define DIM     ( 5 ) // Dimension of the game (DIMxDIM)
@@ -246,6 +248,7 @@ static bool user_input_to_start(void)
 {
     char   select;
     int    toss;
+    rng_t  rng;
     int    i, j;
         
     // Ask for user input to select between single player and multiplayer
@@ -271,8 +274,8 @@ static bool user_input_to_start(void)
         return false; 
     }
     
-    srand((unsigned int)time(0));
-    toss = rand()%2;
+    rng_seed(&rng, (uint64_t)time(0));
+    toss = (int)rng_bounded(&rng, 2);
     //printf("%d\n",toss);
     if( select == 'H' || select == 'h' ) {
         firstone = (toss == 0)? PlayerB: PlayerA;
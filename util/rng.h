@@ -0,0 +1,92 @@
+/********************************************************************
+  Author: Vikas Yadav
+  Filename: rng.h
+  Copyright (c) 2017-2026 Vikas Yadav. All rights reserved.
+
+  Random numbers for the games and simulators: a xoshiro256**
+  generator, header-only, usable from C and C++.
+
+  Each generator is a plain value with no global state, so threads
+  just own one apiece. rng_jump() advances a stream by 2^128 draws:
+  seed one stream, then jump it once per worker, and worker k's draws
+  never overlap another's and depend only on (seed, k).
+
+  Usage:
+    rng_t rng;
+    rng_seed(&rng, (uint64_t)time(NULL));
+    int die = 1 + (int)rng_bounded(&rng, 6);    (no modulo bias)
+    double u = rng_double(&rng);                (in [0, 1))
+********************************************************************/
+#ifndef UTIL_RNG_H
+#define UTIL_RNG_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint64_t s[4];
+} rng_t;
+
+static inline uint64_t rotl64(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(rng_t *r)
+{
+    uint64_t *s = r->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+/* Expand a 64-bit seed into the full state with splitmix64 */
+static inline void rng_seed(rng_t *r, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        r->s[i] = z ^ (z >> 31);
+    }
+}
+
+/* Advance the stream by 2^128 draws */
+static inline void rng_jump(rng_t *r)
+{
+    static const uint64_t JUMP[4] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+        0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+    };
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; i++)
+        for (int b = 0; b < 64; b++) {
+            if (JUMP[i] & (1ULL << b)) {
+                s0 ^= r->s[0]; s1 ^= r->s[1]; s2 ^= r->s[2]; s3 ^= r->s[3];
+            }
+            rng_next(r);
+        }
+    r->s[0] = s0; r->s[1] = s1; r->s[2] = s2; r->s[3] = s3;
+}
+
+/* Uniform integer in [0, n) without modulo bias (Lemire's method) */
+static inline uint32_t rng_bounded(rng_t *r, uint32_t n)
+{
+    uint64_t m = (uint64_t)(uint32_t)(rng_next(r) >> 32) * n;
+    if ((uint32_t)m < n) {
+        uint32_t threshold = (uint32_t)-n % n;
+        while ((uint32_t)m < threshold)
+            m = (uint64_t)(uint32_t)(rng_next(r) >> 32) * n;
+    }
+    return (uint32_t)(m >> 32);
+}
+
+/* Uniform double in [0, 1) from the top 53 bits */
+static inline double rng_double(rng_t *r)
+{
+    return (double)(rng_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#endif  /* UTIL_RNG_H */